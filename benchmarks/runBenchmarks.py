@@ -0,0 +1,125 @@
+#!/usr/bin/python3
+
+#
+# Compiles every benchmark program in this directory with each of its
+# configurations and reports the best wall clock time out of several runs,
+# together with the size of the executable.
+#
+# A benchmark lists the compiler flags to compare in a comment line like
+#
+#   // configurations: -O2 -fno-inline; -O2
+#
+# If no such line is present, the benchmark is compiled with -O2 only.
+# Short running benchmarks can raise the number of runs with a line like
+#
+#   // runs: 200
+#
+# A configuration containing -fprofile-use without a file name is built
+# twice: first with -fprofile-generate instead, then the instrumented
+# executable is run once as training run and its profile is merged with
+# llvm-profdata (or $LLVM_PROFDATA) and passed to the second build.
+#
+
+import sys
+import os
+import subprocess
+import time
+
+
+if len(sys.argv) <= 1:
+    print("please specify the qlow executable as a command line argument")
+    exit()
+
+qlow_executable = sys.argv[1]
+runs = 5
+
+
+def read_configurations(path):
+    with open(path, "r") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("// configurations:"):
+                configs = line[len("// configurations:"):].split(";")
+                return [c.split() for c in configs]
+    return [["-O2"]]
+
+
+def read_runs(path):
+    with open(path, "r") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("// runs:"):
+                return int(line[len("// runs:"):])
+    return runs
+
+
+def time_executable(exefile, runs):
+    best = None
+    for i in range(runs):
+        start = time.perf_counter()
+        subprocess.run([exefile], stdout=subprocess.DEVNULL)
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+
+def train_profile(path, flags):
+    exefile = path + ".train"
+    rawfile = path + ".profraw"
+    datafile = path + ".profdata"
+    compile = [qlow_executable, path, "-o", exefile, "-fprofile-generate"] + flags
+    result = subprocess.run(compile, stdout=subprocess.PIPE)
+    if result.returncode != 0 or not os.path.isfile(exefile):
+        return None
+    env = dict(os.environ, LLVM_PROFILE_FILE=rawfile)
+    subprocess.run([exefile], stdout=subprocess.DEVNULL, env=env)
+    os.remove(exefile)
+    profdata = os.environ.get("LLVM_PROFDATA", "llvm-profdata")
+    result = subprocess.run([profdata, "merge", "-o", datafile, rawfile])
+    if os.path.isfile(rawfile):
+        os.remove(rawfile)
+    if result.returncode != 0:
+        return None
+    return datafile
+
+
+def bench_file(path):
+    print(path)
+    for flags in read_configurations(path):
+        exefile = path + ".bench"
+        datafile = None
+        build_flags = flags
+        if "-fprofile-use" in flags:
+            others = [f for f in flags if f != "-fprofile-use"]
+            datafile = train_profile(path, others)
+            if datafile is None:
+                print("    %-40s training run failed" % " ".join(flags))
+                continue
+            build_flags = others + ["-fprofile-use=" + datafile]
+        compile = [qlow_executable, path, "-o", exefile] + build_flags
+        result = subprocess.run(compile, stdout=subprocess.PIPE)
+        if datafile is not None:
+            os.remove(datafile)
+        if result.returncode != 0 or not os.path.isfile(exefile):
+            print("    %-40s compilation failed" % " ".join(flags))
+            continue
+        elapsed = time_executable(exefile, read_runs(path))
+        size = os.path.getsize(exefile)
+        print("    %-40s %10.3f ms %8d bytes" % (" ".join(flags), elapsed * 1000, size))
+        os.remove(exefile)
+
+
+def run_directory(dir):
+    for root, dirs, files in os.walk(dir):
+        for filename in sorted(files):
+            if filename.endswith(".qlw"):
+                bench_file(os.path.join(root, filename))
+
+
+if len(sys.argv) > 2:
+    for path in sys.argv[2:]:
+        bench_file(path)
+else:
+    run_directory(os.path.dirname(os.path.abspath(__file__)))
+
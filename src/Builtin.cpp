@@ -3,6 +3,8 @@
 #include "Type.h"
 #include "Context.h"
 
+#include <llvm/IR/Intrinsics.h>
+
 #ifdef DEBUGGING
 #include <llvm/Support/raw_os_ostream.h>
 #endif
@@ -134,6 +136,14 @@ void qlow::sem::fillNativeScope(NativeScope& scope)
         NativeType::NType::C_SHORT,
         NativeType::NType::C_INT,
         NativeType::NType::C_LONG,
+        NativeType::NType::INT8,
+        NativeType::NType::INT16,
+        NativeType::NType::INT32,
+        NativeType::NType::INT64,
+        NativeType::NType::UINT8,
+        NativeType::NType::UINT16,
+        NativeType::NType::UINT32,
+        NativeType::NType::UINT64,
     };
 
     for (auto integerType : integerTypes) {
@@ -142,12 +152,124 @@ void qlow::sem::fillNativeScope(NativeScope& scope)
             std::make_unique<NativeTypeScope>(generateNativeTypeScope(context, integerType))
         );
     }
+
+    Type* boolean = context.getNativeType(NativeType::NType::BOOLEAN);
+    boolean->setTypeScope(
+        std::make_unique<NativeTypeScope>(generateBooleanTypeScope(context))
+    );
+
+    static const std::vector<NativeType::NType> floatTypes {
+        NativeType::NType::FLOAT32,
+        NativeType::NType::FLOAT64,
+    };
+
+    for (auto floatType : floatTypes) {
+        Type* floatingPoint = context.getNativeType(floatType);
+        floatingPoint->setTypeScope(
+            std::make_unique<NativeTypeScope>(generateFloatTypeScope(context, floatType))
+        );
+    }
+
+    for (auto nativeType : NativeType::nativeTypes) {
+        auto* native = static_cast<NativeType*>(context.getNativeType(nativeType));
+        if (native->isVectorType()) {
+            native->setTypeScope(
+                std::make_unique<NativeTypeScope>(generateVectorTypeScope(context, nativeType))
+            );
+        }
+    }
+}
+
+
+/*!
+ * \brief adds the bit manipulation and overflow checking methods of an
+ *        integer type, which map to single llvm intrinsics
+ */
+static void addIntegerIntrinsics(sem::NativeTypeScope& scope, sem::Context& context,
+    sem::NativeType::NType native)
+{
+    using llvm::Value;
+    using llvm::Intrinsic::ID;
+    using Builder = llvm::IRBuilder<>;
+    using sem::NativeType;
+
+    sem::NativeScope& nativeScope = context.getNativeScope();
+    sem::Type* type = context.getNativeType(native);
+    sem::Type* boolean = context.getNativeType(NativeType::NType::BOOLEAN);
+    bool isUnsigned = static_cast<NativeType*>(type)->isUnsignedType();
+    bool isByte = native == NativeType::NType::INT8 ||
+        native == NativeType::NType::UINT8 ||
+        native == NativeType::NType::C_CHAR;
+
+    auto addUnary = [&] (const std::string& name,
+            std::function<Value*(Builder&, Value*)>&& generator) {
+        scope.nativeMethods.insert({ name,
+            std::make_unique<sem::UnaryNativeMethod>(nativeScope, type, generator) });
+    };
+    auto addBinary = [&] (const std::string& name, sem::Type* returnType,
+            sem::BinaryNativeMethod::Func&& generator) {
+        scope.nativeMethods.insert({ name,
+            std::make_unique<sem::BinaryNativeMethod>(nativeScope, returnType,
+                type, std::move(generator)) });
+    };
+
+    addUnary("popcount", [] (Builder& builder, Value* x) {
+        return builder.CreateUnaryIntrinsic(llvm::Intrinsic::ctpop, x);
+    });
+    // the second argument defines the result for 0 as the bit width
+    addUnary("leading_zeros", [] (Builder& builder, Value* x) {
+        return builder.CreateIntrinsic(llvm::Intrinsic::ctlz, { x->getType() },
+            { x, builder.getFalse() });
+    });
+    addUnary("trailing_zeros", [] (Builder& builder, Value* x) {
+        return builder.CreateIntrinsic(llvm::Intrinsic::cttz, { x->getType() },
+            { x, builder.getFalse() });
+    });
+    if (!isByte) {
+        addUnary("byte_swap", [] (Builder& builder, Value* x) {
+            return builder.CreateUnaryIntrinsic(llvm::Intrinsic::bswap, x);
+        });
+    }
+
+    // a funnel shift of a value with itself is a rotation, the amount is
+    // taken modulo the bit width
+    addBinary("rotate_left", type, [] (Builder& builder, Value* x, Value* n) {
+        return builder.CreateIntrinsic(llvm::Intrinsic::fshl, { x->getType() }, { x, x, n });
+    });
+    addBinary("rotate_right", type, [] (Builder& builder, Value* x, Value* n) {
+        return builder.CreateIntrinsic(llvm::Intrinsic::fshr, { x->getType() }, { x, x, n });
+    });
+
+    // x.add_overflow(y) is true if x + y does not fit into the type
+    auto overflows = [] (ID intrinsic) {
+        return [intrinsic] (Builder& builder, Value* a, Value* b) {
+            Value* result = builder.CreateBinaryIntrinsic(intrinsic, a, b);
+            return builder.CreateExtractValue(result, { 1 });
+        };
+    };
+    addBinary("add_overflow", boolean, overflows(isUnsigned ?
+        llvm::Intrinsic::uadd_with_overflow : llvm::Intrinsic::sadd_with_overflow));
+    addBinary("sub_overflow", boolean, overflows(isUnsigned ?
+        llvm::Intrinsic::usub_with_overflow : llvm::Intrinsic::ssub_with_overflow));
+    addBinary("mul_overflow", boolean, overflows(isUnsigned ?
+        llvm::Intrinsic::umul_with_overflow : llvm::Intrinsic::smul_with_overflow));
+
+    auto saturating = [] (ID intrinsic) {
+        return [intrinsic] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateBinaryIntrinsic(intrinsic, a, b);
+        };
+    };
+    addBinary("saturating_add", type, saturating(isUnsigned ?
+        llvm::Intrinsic::uadd_sat : llvm::Intrinsic::sadd_sat));
+    addBinary("saturating_sub", type, saturating(isUnsigned ?
+        llvm::Intrinsic::usub_sat : llvm::Intrinsic::ssub_sat));
 }
 
 
 sem::NativeTypeScope qlow::sem::generateNativeTypeScope(Context& context, NativeType::NType native)
 {
     NativeTypeScope scope{ context, context.getNativeType(native) };
+    bool isUnsigned = static_cast<NativeType*>(context.getNativeType(native))->isUnsignedType();
 
 
     scope.nativeMethods.insert(
@@ -185,11 +307,79 @@ sem::NativeTypeScope qlow::sem::generateNativeTypeScope(Context& context, Native
     );
     scope.nativeMethods.insert(
         { "/",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [isUnsigned] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return isUnsigned ? builder.CreateUDiv(a, b) : builder.CreateSDiv(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "%",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [isUnsigned] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return isUnsigned ? builder.CreateURem(a, b) : builder.CreateSRem(a, b);
+                }
+            )
+        }
+    );
+
+
+    scope.nativeMethods.insert(
+        { "&",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateAnd(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "|",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateOr(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "^",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateXor(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "<<",
             std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
                 context.getNativeType(native),
                 context.getNativeType(native),
                 [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
-                    return builder.CreateSDiv(a, b);
+                    return builder.CreateShl(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { ">>",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [isUnsigned] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return isUnsigned ? builder.CreateLShr(a, b) : builder.CreateAShr(a, b);
                 }
             )
         }
@@ -218,13 +408,226 @@ sem::NativeTypeScope qlow::sem::generateNativeTypeScope(Context& context, Native
             )
         }
     );
+    scope.nativeMethods.insert(
+        { "<",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [isUnsigned] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return isUnsigned ? builder.CreateICmpULT(a, b) : builder.CreateICmpSLT(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { ">",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [isUnsigned] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return isUnsigned ? builder.CreateICmpUGT(a, b) : builder.CreateICmpSGT(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "<=",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [isUnsigned] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return isUnsigned ? builder.CreateICmpULE(a, b) : builder.CreateICmpSLE(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { ">=",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [isUnsigned] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return isUnsigned ? builder.CreateICmpUGE(a, b) : builder.CreateICmpSGE(a, b);
+                }
+            )
+        }
+    );
+
+    addIntegerIntrinsics(scope, context, native);
+
+    return scope;
+}
+
+
+sem::NativeTypeScope qlow::sem::generateBooleanTypeScope(Context& context)
+{
+    NativeType::NType native = NativeType::NType::BOOLEAN;
+    NativeTypeScope scope{ context, context.getNativeType(native) };
+
+
+    // the expression visitor short-circuits 'and' and 'or' instead of
+    // calling these, they only make the operators resolvable
+    scope.nativeMethods.insert(
+        { "and",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateAnd(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "or",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateOr(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "xor",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateXor(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "==",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateICmpEQ(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "!=",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateICmpNE(a, b);
+                }
+            )
+        }
+    );
+
+    return scope;
+}
+
+
+sem::NativeTypeScope qlow::sem::generateArrayTypeScope(Context& context, Type* arrayType)
+{
+    NativeTypeScope scope{ context, arrayType };
+
+    // arrays are accessed through a pointer to their { elements, length } struct
+    auto length = std::make_unique<UnaryNativeMethod>(context.getNativeScope(),
+        context.getNativeType(NativeType::NType::INTEGER),
+        [] (llvm::IRBuilder<>& builder, llvm::Value* array) {
+            llvm::Type* arrayStructType = array->getType()->getPointerElementType();
+            llvm::Value* lengthPtr = builder.CreateStructGEP(arrayStructType, array, 1);
+            return builder.CreateLoad(builder.getInt64Ty(), lengthPtr);
+        }
+    );
+    length->name = "length";
+    scope.nativeMethods.insert({ "length", std::move(length) });
+
+    return scope;
+}
+
+
+sem::NativeTypeScope qlow::sem::generateFloatTypeScope(Context& context, NativeType::NType native)
+{
+    NativeTypeScope scope{ context, context.getNativeType(native) };
+
+
+    scope.nativeMethods.insert(
+        { "+",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFAdd(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "-",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFSub(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "*",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFMul(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "/",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(native),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFDiv(a, b);
+                }
+            )
+        }
+    );
+
+
+    // comparisons are ordered, except for != which holds for NaNs
+    scope.nativeMethods.insert(
+        { "==",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFCmpOEQ(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "!=",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFCmpUNE(a, b);
+                }
+            )
+        }
+    );
     scope.nativeMethods.insert(
         { "<",
             std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
                 context.getNativeType(NativeType::NType::BOOLEAN),
                 context.getNativeType(native),
                 [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
-                    return builder.CreateICmpSLT(a, b);
+                    return builder.CreateFCmpOLT(a, b);
                 }
             )
         }
@@ -235,11 +638,245 @@ sem::NativeTypeScope qlow::sem::generateNativeTypeScope(Context& context, Native
                 context.getNativeType(NativeType::NType::BOOLEAN),
                 context.getNativeType(native),
                 [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
-                    return builder.CreateICmpSGT(a, b);
+                    return builder.CreateFCmpOGT(a, b);
+                }
+            )
+        }
+    );
+    scope.nativeMethods.insert(
+        { "<=",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFCmpOLE(a, b);
                 }
             )
         }
     );
+    scope.nativeMethods.insert(
+        { ">=",
+            std::make_unique<BinaryNativeMethod>(context.getNativeScope(),
+                context.getNativeType(NativeType::NType::BOOLEAN),
+                context.getNativeType(native),
+                [] (llvm::IRBuilder<>& builder, llvm::Value* a, llvm::Value* b) {
+                    return builder.CreateFCmpOGE(a, b);
+                }
+            )
+        }
+    );
+
+    return scope;
+}
+
+
+#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 11
+using ShuffleMask = std::vector<int>;
+#else
+using ShuffleMask = std::vector<uint32_t>;
+#endif
+
+
+static unsigned getLaneCount(llvm::Value* vector)
+{
+#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 11
+    return llvm::cast<llvm::FixedVectorType>(vector->getType())->getNumElements();
+#else
+    return vector->getType()->getVectorNumElements();
+#endif
+}
+
+
+/// turns the result of a vector comparison into lanes of all ones or zeros
+static llvm::Value* createMask(llvm::IRBuilder<>& builder, llvm::Value* comparison, llvm::Value* operand)
+{
+    auto* vectorType = llvm::cast<llvm::VectorType>(operand->getType());
+    return builder.CreateSExt(comparison, llvm::VectorType::getInteger(vectorType));
+}
+
+
+/// the integer vector type holding the result of comparisons
+static sem::NativeType::NType getMaskType(sem::NativeType::NType vector)
+{
+    switch (vector) {
+    case sem::NativeType::NType::FLOAT32X8:
+        return sem::NativeType::NType::INT32X8;
+    case sem::NativeType::NType::FLOAT64X4:
+        return sem::NativeType::NType::INT64X4;
+    default:
+        return vector;
+    }
+}
+
+
+sem::NativeTypeScope qlow::sem::generateVectorTypeScope(Context& context, NativeType::NType vector)
+{
+    using llvm::Value;
+    using Builder = llvm::IRBuilder<>;
+
+    NativeTypeScope scope{ context, context.getNativeType(vector) };
+    NativeScope& nativeScope = context.getNativeScope();
+
+    Type* vectorType = context.getNativeType(vector);
+    Type* maskType = context.getNativeType(getMaskType(vector));
+    Type* integer = context.getNativeType(NativeType::NType::INTEGER);
+    bool isFloat = vector == NativeType::NType::FLOAT32X8 ||
+        vector == NativeType::NType::FLOAT64X4;
+    Type* floatLane = context.getNativeType(vector == NativeType::NType::FLOAT32X8 ?
+        NativeType::NType::FLOAT32 : NativeType::NType::FLOAT64);
+
+    auto addUnary = [&] (const std::string& name, Type* returnType,
+            std::function<Value*(Builder&, Value*)>&& generator) {
+        scope.nativeMethods.insert({ name,
+            std::make_unique<UnaryNativeMethod>(nativeScope, returnType, generator) });
+    };
+    auto addBinary = [&] (const std::string& name, Type* returnType,
+            Type* argumentType, BinaryNativeMethod::Func&& generator) {
+        scope.nativeMethods.insert({ name,
+            std::make_unique<BinaryNativeMethod>(nativeScope, returnType,
+                argumentType, std::move(generator)) });
+    };
+    auto addTernary = [&] (const std::string& name, Type* returnType,
+            Type* argument1Type, Type* argument2Type, TernaryNativeMethod::Func&& generator) {
+        scope.nativeMethods.insert({ name,
+            std::make_unique<TernaryNativeMethod>(nativeScope, returnType,
+                argument1Type, argument2Type, std::move(generator)) });
+    };
+
+    // element-wise arithmetic and comparisons, comparisons set all bits of
+    // the lanes where they hold
+    if (isFloat) {
+        addBinary("+", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateFAdd(a, b);
+        });
+        addBinary("-", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateFSub(a, b);
+        });
+        addBinary("*", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateFMul(a, b);
+        });
+        addBinary("/", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateFDiv(a, b);
+        });
+        addBinary("==", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateFCmpOEQ(a, b), a);
+        });
+        addBinary("!=", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateFCmpUNE(a, b), a);
+        });
+        addBinary("<", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateFCmpOLT(a, b), a);
+        });
+        addBinary(">", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateFCmpOGT(a, b), a);
+        });
+
+        addBinary("lane", floatLane, integer, [] (Builder& builder, Value* v, Value* lane) {
+            return builder.CreateExtractElement(v, lane);
+        });
+        addTernary("with_lane", vectorType, integer, floatLane,
+            [] (Builder& builder, Value* v, Value* lane, Value* value) {
+                return builder.CreateInsertElement(v, value, lane);
+            }
+        );
+
+        // the sum is only reassociated into a tree with fast-math flags
+        addUnary("sum", floatLane, [] (Builder& builder, Value* v) {
+            Value* negativeZero = llvm::ConstantFP::getNegativeZero(v->getType()->getScalarType());
+            return builder.CreateFAddReduce(negativeZero, v);
+        });
+        addUnary("min", floatLane, [] (Builder& builder, Value* v) {
+            return builder.CreateFPMinReduce(v);
+        });
+        addUnary("max", floatLane, [] (Builder& builder, Value* v) {
+            return builder.CreateFPMaxReduce(v);
+        });
+    }
+    else {
+        addBinary("+", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateAdd(a, b);
+        });
+        addBinary("-", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateSub(a, b);
+        });
+        addBinary("*", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateMul(a, b);
+        });
+        addBinary("/", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return builder.CreateSDiv(a, b);
+        });
+        addBinary("==", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateICmpEQ(a, b), a);
+        });
+        addBinary("!=", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateICmpNE(a, b), a);
+        });
+        addBinary("<", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateICmpSLT(a, b), a);
+        });
+        addBinary(">", maskType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+            return createMask(builder, builder.CreateICmpSGT(a, b), a);
+        });
+
+        // lanes are read and written as Integer
+        addBinary("lane", integer, integer, [] (Builder& builder, Value* v, Value* lane) {
+            return builder.CreateSExtOrTrunc(builder.CreateExtractElement(v, lane),
+                builder.getInt64Ty());
+        });
+        addTernary("with_lane", vectorType, integer, integer,
+            [] (Builder& builder, Value* v, Value* lane, Value* value) {
+                llvm::Type* laneType = v->getType()->getScalarType();
+                return builder.CreateInsertElement(v,
+                    builder.CreateSExtOrTrunc(value, laneType), lane);
+            }
+        );
+
+        // horizontal reductions
+        addUnary("sum", integer, [] (Builder& builder, Value* v) {
+            return builder.CreateSExtOrTrunc(builder.CreateAddReduce(v), builder.getInt64Ty());
+        });
+        addUnary("min", integer, [] (Builder& builder, Value* v) {
+            return builder.CreateSExtOrTrunc(builder.CreateIntMinReduce(v, true), builder.getInt64Ty());
+        });
+        addUnary("max", integer, [] (Builder& builder, Value* v) {
+            return builder.CreateSExtOrTrunc(builder.CreateIntMaxReduce(v, true), builder.getInt64Ty());
+        });
+    }
+
+    // takes the lanes of 'other' where the mask is set
+    addTernary("blend", vectorType, maskType, vectorType,
+        [] (Builder& builder, Value* v, Value* mask, Value* other) {
+            Value* condition = builder.CreateICmpNE(mask,
+                llvm::Constant::getNullValue(mask->getType()));
+            return builder.CreateSelect(condition, other, v);
+        }
+    );
+
+    // shuffles
+    addUnary("reverse", vectorType, [] (Builder& builder, Value* v) {
+        unsigned lanes = getLaneCount(v);
+        ShuffleMask mask;
+        for (unsigned i = 0; i < lanes; i++)
+            mask.push_back(lanes - 1 - i);
+        return builder.CreateShuffleVector(v, v, mask);
+    });
+    addBinary("broadcast", vectorType, integer, [] (Builder& builder, Value* v, Value* lane) {
+        return builder.CreateVectorSplat(getLaneCount(v), builder.CreateExtractElement(v, lane));
+    });
+    addBinary("interleave_low", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+        unsigned lanes = getLaneCount(a);
+        ShuffleMask mask;
+        for (unsigned i = 0; i < lanes; i++)
+            mask.push_back(i / 2 + (i % 2) * lanes);
+        return builder.CreateShuffleVector(a, b, mask);
+    });
+    addBinary("interleave_high", vectorType, vectorType, [] (Builder& builder, Value* a, Value* b) {
+        unsigned lanes = getLaneCount(a);
+        ShuffleMask mask;
+        for (unsigned i = 0; i < lanes; i++)
+            mask.push_back(lanes / 2 + i / 2 + (i % 2) * lanes);
+        return builder.CreateShuffleVector(a, b, mask);
+    });
 
     return scope;
 }
@@ -272,7 +909,10 @@ llvm::Value* qlow::sem::BinaryNativeMethod::generateCode(llvm::IRBuilder<>& buil
 }
 
 
-
-
-
-
+llvm::Value* qlow::sem::TernaryNativeMethod::generateCode(llvm::IRBuilder<>& builder,
+    std::vector<llvm::Value*> arguments)
+{
+    if (arguments.size() != 3)
+        throw "invalid ternary operation";
+    return generator(builder, arguments[0], arguments[1], arguments[2]);
+}
@@ -19,10 +19,15 @@ namespace qlow
         void fillNativeScope(NativeScope& scope);
 
         NativeTypeScope generateNativeTypeScope(Context& context, NativeType::NType native);
+        NativeTypeScope generateFloatTypeScope(Context& context, NativeType::NType native);
+        NativeTypeScope generateBooleanTypeScope(Context& context);
+        NativeTypeScope generateArrayTypeScope(Context& context, Type* arrayType);
+        NativeTypeScope generateVectorTypeScope(Context& context, NativeType::NType vector);
         
         struct NativeMethod;
         struct UnaryNativeMethod;
         struct BinaryNativeMethod;
+        struct TernaryNativeMethod;
     }
 }
 
@@ -80,6 +85,33 @@ struct qlow::sem::BinaryNativeMethod : public sem::NativeMethod
                                       std::vector<llvm::Value*> arguments);
 };
 
+
+struct qlow::sem::TernaryNativeMethod : public sem::NativeMethod
+{
+    using Func = 
+        std::function<llvm::Value*(llvm::IRBuilder<>&, llvm::Value*, llvm::Value*, llvm::Value*)>;
+    
+    Func generator;
+    Variable argument1;
+    Variable argument2;
+    
+    inline TernaryNativeMethod(NativeScope& scope,
+                               Type* returnType,
+                               Type* argument1Type,
+                               Type* argument2Type,
+                               Func&& generator) :
+        NativeMethod{ scope, returnType },
+        generator{ generator },
+        argument1{ context, argument1Type, "arg1" },
+        argument2{ context, argument2Type, "arg2" }
+    {
+        Method::arguments = { &argument1, &argument2 };
+    }
+    
+    virtual llvm::Value* generateCode(llvm::IRBuilder<>& builder,
+                                      std::vector<llvm::Value*> arguments);
+};
+
 #endif // QLOW_SEM_BUILTIN_H
 
 
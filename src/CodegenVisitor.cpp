@@ -14,17 +14,51 @@
 
 using namespace qlow;
 
+
+/// stores a value in a new stack slot of the current function
+static llvm::Value* storeToTemporary(llvm::Value* value, gen::FunctionGenerator& fg)
+{
+    llvm::Value* temporary = fg.createEntryAlloca(value->getType());
+    fg.builder.CreateStore(value, temporary);
+    return temporary;
+}
+
+
+/// fields of @packed classes can be at any offset, all others are aligned
+static llvm::MaybeAlign getFieldAlignment(const sem::FieldAccessExpression& access)
+{
+    const sem::Type* type = access.target->type;
+    if (type->isClassType() && type->getClass()->packed)
+        return llvm::Align(1);
+    return llvm::MaybeAlign();
+}
+
+
+/// returns a pointer to the struct an expression evaluates to
+static llvm::Value* generateStructAddress(sem::Expression& expr, gen::FunctionGenerator& fg)
+{
+    if (expr.isLValue())
+        return expr.accept(fg.lvalueVisitor, fg);
+    return storeToTemporary(expr.accept(fg.expressionVisitor, fg.builder), fg);
+}
+
+
 llvm::Value* ExpressionCodegenVisitor::visit(sem::LocalVariableExpression& lve, llvm::IRBuilder<>& builder)
 {
-    assert(lve.var->allocaInst != nullptr);
-    // TODO improve handling of arrays and structs
-    if (llvm::dyn_cast<llvm::AllocaInst>(lve.var->allocaInst) && !lve.type->isArrayType() && !lve.type->isStructType()) {
-        llvm::Type* returnType = lve.type->getLlvmType(builder.getContext());
-        llvm::Value* val = builder.CreateLoad(returnType, lve.var->allocaInst);
+    llvm::Value* var = fg.session.getVariable(lve.var);
+    // struct variables always live in memory, either on the stack or in a
+    // byval argument. They are copied as a whole, so SROA can split them up.
+    if (lve.type->isStructType()) {
+        return builder.CreateLoad(fg.session.getLlvmType(lve.type), var);
+    }
+    // TODO improve handling of arrays
+    else if (llvm::dyn_cast<llvm::AllocaInst>(var) && !lve.type->isArrayType()) {
+        llvm::Type* returnType = fg.session.getLlvmType(lve.type);
+        llvm::Value* val = builder.CreateLoad(returnType, var);
         return val;
     }
     else {
-        return lve.var->allocaInst;
+        return var;
     }
 }
 
@@ -51,10 +85,56 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::UnaryOperation& unop, llvm::IR
 }
 
 
+/*!
+ * \brief generates <code>a and b</code> or <code>a or b</code>, evaluating
+ *        <code>b</code> only if <code>a</code> does not decide the result
+ */
+static llvm::Value* generateShortCircuit(sem::BinaryOperation& binop,
+    ExpressionCodegenVisitor& visitor, llvm::IRBuilder<>& builder)
+{
+    using llvm::BasicBlock;
+
+    bool isAnd = binop.opString == "and";
+    llvm::Function* function = builder.GetInsertBlock()->getParent();
+
+    llvm::Value* left = binop.left->accept(visitor, builder);
+    BasicBlock* leftEnd = builder.GetInsertBlock();
+    BasicBlock* rightBlock = BasicBlock::Create(builder.getContext(),
+        isAnd ? "and.rhs" : "or.rhs", function);
+    BasicBlock* merge = BasicBlock::Create(builder.getContext(),
+        isAnd ? "and.end" : "or.end", function);
+
+    if (isAnd)
+        builder.CreateCondBr(left, rightBlock, merge);
+    else
+        builder.CreateCondBr(left, merge, rightBlock);
+
+    builder.SetInsertPoint(rightBlock);
+    visitor.fg.setCurrentBlock(rightBlock);
+    llvm::Value* right = binop.right->accept(visitor, builder);
+    BasicBlock* rightEnd = builder.GetInsertBlock();
+    builder.CreateBr(merge);
+
+    builder.SetInsertPoint(merge);
+    visitor.fg.setCurrentBlock(merge);
+    llvm::PHINode* result = builder.CreatePHI(builder.getInt1Ty(), 2);
+    result->addIncoming(builder.getInt1(!isAnd), leftEnd);
+    result->addIncoming(right, rightEnd);
+    return result;
+}
+
+
 llvm::Value* ExpressionCodegenVisitor::visit(sem::BinaryOperation& binop, llvm::IRBuilder<>& builder)
 {
     using llvm::Value;
     using sem::Type;
+
+    if ((binop.opString == "and" || binop.opString == "or") &&
+        binop.left->type == binop.context.getNativeType(sem::NativeType::NType::BOOLEAN) &&
+        dynamic_cast<sem::NativeMethod*>(binop.operationMethod) != nullptr) {
+        return generateShortCircuit(binop, *this, builder);
+    }
+
     auto left = binop.left->accept(*this, builder);
     auto right = binop.right->accept(*this, builder);
     
@@ -118,13 +198,38 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::BinaryOperation& binop, llvm::
 }
 
 
+/// converts a scalar between native types, extending according to the
+/// signedness of the source and the target type
+static llvm::Value* convertScalar(llvm::IRBuilder<>& builder, llvm::Value* value,
+    sem::Type* from, sem::Type* to, llvm::Type* llvmTo)
+{
+    if (value->getType() == llvmTo)
+        return value;
+    auto isSigned = [] (sem::Type* type) {
+        return !type->isNativeType() ||
+            !static_cast<sem::NativeType*>(type)->isUnsignedType();
+    };
+    auto opcode = llvm::CastInst::getCastOpcode(value, isSigned(from), llvmTo, isSigned(to));
+    return builder.CreateCast(opcode, value, llvmTo);
+}
+
+
 llvm::Value* ExpressionCodegenVisitor::visit(sem::CastExpression& cast, llvm::IRBuilder<>& builder)
 {
+    auto* targetType = cast.targetType;
+    if (cast.isNativeCast && static_cast<sem::NativeType*>(targetType)->isVectorType()) {
+        auto* vectorType = static_cast<sem::NativeType*>(targetType);
+        llvm::Type* laneType = fg.session.getLlvmType(vectorType)->getScalarType();
+        llvm::Value* value = cast.expression->accept(*this, builder);
+        value = convertScalar(builder, value, cast.expression->type, vectorType, laneType);
+        return builder.CreateVectorSplat(vectorType->getLaneCount(), value);
+    }
     if (cast.isNativeCast) {
-        return builder.CreateCast(
-            llvm::Instruction::CastOps::SExt,
+        return convertScalar(builder,
             cast.expression->accept(*this, builder),
-            cast.targetType->getLlvmType(builder.getContext())
+            cast.expression->type,
+            cast.targetType,
+            fg.session.getLlvmType(cast.targetType)
         );
     }
     return nullptr;
@@ -139,14 +244,12 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::NewExpression& nexpr, llvm::IR
     sem::Type* type = nexpr.type;
 
     const llvm::DataLayout& layout = builder.GetInsertBlock()->getModule()->getDataLayout();
-    llvm::Type* llvmTy = type->getLlvmType(builder.getContext())->getPointerElementType();
+    llvm::Type* llvmTy = fg.session.getLlvmType(type)->getPointerElementType();
     auto allocSize = layout.getTypeAllocSize(llvmTy);
 
-    auto size = llvm::ConstantInt::get(builder.getContext(), llvm::APInt(32, allocSize, false));
-    auto mallocCall = llvm::CallInst::CreateMalloc(builder.GetInsertBlock(), size->getType(), llvmTy, size, nullptr, nullptr, "");
-    //auto casted = builder.CreateBitCast(mallocCall, llvmTy);
-    builder.GetInsertBlock()->getInstList().push_back(llvm::cast<llvm::Instruction>(mallocCall));
-    return mallocCall;
+    auto size = llvm::ConstantInt::get(builder.getInt64Ty(), allocSize);
+    llvm::Value* memory = fg.generateAllocation(size, fg.session.getStructAlignment(type));
+    return builder.CreateBitCast(memory, llvmTy->getPointerTo());
 }
 
 
@@ -158,22 +261,30 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::NewArrayExpression& naexpr, ll
     llvm::LLVMContext& llvmCtxt = builder.getContext();
 
     const llvm::DataLayout& layout = builder.GetInsertBlock()->getModule()->getDataLayout();
-    llvm::Type* llvmTy = naexpr.elementType->getLlvmType(llvmCtxt);
-    llvm::Type* arrayStructType = naexpr.type->getLlvmType(llvmCtxt);
-    auto elementSize = layout.getTypeAllocSize(llvmTy);
+    llvm::Type* llvmTy = fg.session.getLlvmType(naexpr.elementType);
+    llvm::Type* arrayStructType = fg.session.getLlvmType(naexpr.type);
+    uint64_t elementSize = layout.getTypeAllocSize(llvmTy);
+    unsigned alignment = fg.session.getAlignment(naexpr.elementType);
+
+    // an @soa array holds all of its columns in the same allocation
+    if (naexpr.type->isSoaArrayType()) {
+        auto soaLayout = fg.session.getSoaLayout(naexpr.elementType);
+        elementSize = soaLayout.elementSize;
+        alignment = soaLayout.alignment;
+    }
 
-    llvm::Value* lengthExpr = naexpr.length->accept(*this, builder);
+    llvm::Value* lengthExpr = fg.generateIndex(naexpr.length->accept(*this, builder),
+        naexpr.length->type);
     llvm::Value* allocSize = builder.CreateMul(lengthExpr, llvm::ConstantInt::get(llvm::Type::getInt64Ty(llvmCtxt), elementSize));
 
-    auto mallocCall = llvm::CallInst::CreateMalloc(builder.GetInsertBlock(), allocSize->getType(), llvmTy, allocSize, nullptr, nullptr, "");
-    //auto casted = builder.CreateBitCast(mallocCall, llvmTy);
-    builder.GetInsertBlock()->getInstList().push_back(llvm::cast<llvm::Instruction>(mallocCall));
+    llvm::Value* memory = fg.generateAllocation(allocSize, alignment);
+    llvm::Value* elements = builder.CreateBitCast(memory, arrayStructType->getStructElementType(0));
 
-    llvm::Value* result = builder.CreateAlloca(arrayStructType);
+    llvm::Value* result = fg.createEntryAlloca(arrayStructType);
     llvm::Value* arrRef = builder.CreateStructGEP(arrayStructType, result, 0);
     llvm::Value* lenRef = builder.CreateStructGEP(arrayStructType, result, 1);
 
-    builder.CreateStore(mallocCall, arrRef);
+    builder.CreateStore(elements, arrRef);
     builder.CreateStore(lengthExpr, lenRef);
 
     return result; // builder.CreateGEP(result, llvm::ConstantInt::get(llvm::Type::getInt64Ty(llvmCtxt), 0));
@@ -193,16 +304,17 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::MethodCallExpression& call, ll
     std::vector<Value*> arguments;
     
     if (call.target != nullptr) {
-        auto* target = call.target->accept(*this, builder);
+        llvm::Value* target;
+        // methods of structs get a pointer to the struct
+        if (call.target->type->isStructType())
+            target = generateStructAddress(*call.target, fg);
+        else
+            target = call.target->accept(*this, builder);
 
 #ifdef DEBUGGING
         Printer::getInstance() << "creating 'this' argument";
 #endif
-        /*if (llvm::LoadInst* li = llvm::dyn_cast<llvm::LoadInst>(target); li) {
-            llvm::Value* ptr = builder.CreateLoad(semCtxt.getLlvmType(call.target->type, builder.getContext()), li, "ptrload");
-            arguments.push_back(ptr);
-        } else*/
-            arguments.push_back(target);
+        arguments.push_back(target);
     }
     
     for (size_t i = 0; i < call.arguments.size(); i++) {
@@ -216,8 +328,45 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::MethodCallExpression& call, ll
         
         arguments.push_back(value);
     }
+
+    if (auto* nm = dynamic_cast<sem::NativeMethod*>(call.callee); nm) {
+        return nm->generateCode(builder, arguments);
+    }
+
+    llvm::Function* function = fg.session.getFunction(call.callee);
+
+    // arrays are passed as their { elements, length } struct
+    size_t firstArgument = call.target != nullptr ? 1 : 0;
+    for (size_t i = 0; i < call.arguments.size(); i++) {
+        llvm::Value*& argument = arguments[firstArgument + i];
+        if (call.arguments[i]->type->isArrayType() && argument->getType()->isPointerTy()) {
+            argument = builder.CreateLoad(
+                fg.session.getLlvmType(call.arguments[i]->type), argument);
+        }
+    }
+
+    // large struct arguments are passed as pointers to copies
+    unsigned sretArguments = function->hasStructRetAttr() ? 1 : 0;
+    for (size_t i = 0; i < arguments.size(); i++) {
+        if (function->hasParamAttribute(i + sretArguments, llvm::Attribute::AttrKind::ByVal))
+            arguments[i] = storeToTemporary(arguments[i], fg);
+    }
+
+    // large struct results are written to a temporary of the caller
+    if (function->hasStructRetAttr()) {
+        llvm::Type* returnType = fg.session.getLlvmType(call.callee->returnType);
+        llvm::Value* returnSlot = fg.createEntryAlloca(returnType);
+        arguments.insert(arguments.begin(), returnSlot);
+        builder.CreateCall(function, arguments);
+        return builder.CreateLoad(returnType, returnSlot);
+    }
+
     //auto returnType = call.callee->returnType;
-    llvm::CallInst* callInst = builder.CreateCall(call.callee->llvmNode, arguments);
+    llvm::CallInst* callInst = builder.CreateCall(function, arguments);
+    if (call.tailCall == sem::MethodCallExpression::TailCall::TAIL)
+        callInst->setTailCallKind(llvm::CallInst::TCK_Tail);
+    else if (call.tailCall == sem::MethodCallExpression::TailCall::MUST_TAIL)
+        callInst->setTailCallKind(llvm::CallInst::TCK_MustTail);
     return callInst;
 }
 
@@ -229,7 +378,7 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::FieldAccessExpression& access,
 
     sem::Context& semCtxt = access.context;
     
-    Type* type = access.target->type->getLlvmType(builder.getContext());
+    Type* type = fg.session.getLlvmType(access.target->type);
     
     if (type == nullptr)
         throw "no access type";
@@ -237,9 +386,22 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::FieldAccessExpression& access,
         type = type->getPointerElementType();
     }
 
+    unsigned structIndex = fg.session.getStructIndex(access.accessed);
+
+    // fields of structs in memory are loaded directly, fields of
+    // temporaries are extracted from the value
+    if (access.target->type->isStructType()) {
+        if (access.isLValue()) {
+            Value* ptr = access.accept(fg.lvalueVisitor, fg);
+            return builder.CreateAlignedLoad(fg.session.getLlvmType(access.type), ptr,
+                getFieldAlignment(access));
+        }
+        Value* value = access.target->accept(fg.expressionVisitor, builder);
+        return builder.CreateExtractValue(value, { structIndex });
+    }
+
     llvm::Value* target = access.target->accept(fg.expressionVisitor, builder);
 
-    int structIndex = access.accessed->llvmStructIndex;
     /*llvm::ArrayRef<Value*> indexList = {
         llvm::ConstantInt::get(builder.getContext(), llvm::APInt(32, structIndex, false)),
         llvm::ConstantInt::get(builder.getContext(), llvm::APInt(32, 0, false))
@@ -247,7 +409,8 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::FieldAccessExpression& access,
 
     //Value* ptr = builder.CreateGEP(type, target, indexList);
     Value* ptr = fg.builder.CreateStructGEP(type, target, structIndex);
-    return builder.CreateLoad(ptr);
+    return builder.CreateAlignedLoad(fg.session.getLlvmType(access.type), ptr,
+        getFieldAlignment(access));
     
     
     //builder.CreateStructGEP(type,
@@ -275,25 +438,10 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::AddressExpression& node, llvm:
 
 llvm::Value* ExpressionCodegenVisitor::visit(sem::ArrayAccessExpression& node, llvm::IRBuilder<>& builder)
 {
-    auto array = node.array->accept(*this, builder);
-    auto index = node.index->accept(*this, builder);
-
-    auto arrType = node.array->type;
-    if (!arrType->isArrayType()) {
-        throw "trying to access non-array type as array.";
-    }
-
-    sem::ArrayType* at = static_cast<sem::ArrayType*>(arrType);
-    auto elemType = at->getArrayOf();
-
-    auto arrPtr = builder.CreateStructGEP(at->getLlvmType(builder.getContext()), array, 0);
-    // TODO implement range checks
-    //auto length = builder.CreateStructGEP(at->getLlvmType(builder.getContext()), array, 1);
-
-    auto arr = builder.CreateLoad(arrPtr);
-    auto accessVal = builder.CreateGEP(arr, index);
-
-    return builder.CreateLoad(accessVal);
+    if (node.array->type->isSoaArrayType())
+        return fg.generateSoaLoad(fg.generateSoaElement(node));
+    llvm::Value* accessVal = node.accept(fg.lvalueVisitor, fg);
+    return builder.CreateLoad(fg.session.getLlvmType(node.type), accessVal);
 }
 
 
@@ -304,9 +452,19 @@ llvm::Value* ExpressionCodegenVisitor::visit(sem::IntConst& node, llvm::IRBuilde
 }
 
 
+llvm::Value* ExpressionCodegenVisitor::visit(sem::FloatConst& node, llvm::IRBuilder<>& builder)
+{
+    return llvm::ConstantFP::get(builder.getDoubleTy(), node.value);
+}
+
+
 llvm::Value* ExpressionCodegenVisitor::visit(sem::ThisExpression& thisExpr, llvm::IRBuilder<>& builder)
 {
-    return thisExpr.allocaInst;
+    llvm::Value* self = fg.session.getVariable(&thisExpr);
+    // methods of structs receive a pointer, but this is used as the value
+    if (thisExpr.type->isStructType())
+        return builder.CreateLoad(fg.session.getLlvmType(thisExpr.type), self);
+    return self;
 }
 
 
@@ -318,23 +476,16 @@ llvm::Value* LValueVisitor::visit(sem::Expression& e, qlow::gen::FunctionGenerat
 
 llvm::Value* LValueVisitor::visit(sem::LocalVariableExpression& lve, qlow::gen::FunctionGenerator& fg)
 {
-    assert(lve.var->allocaInst != nullptr);
+    llvm::Value* var = fg.session.getVariable(lve.var);
     
-    if (llvm::dyn_cast<llvm::AllocaInst>(lve.var->allocaInst)) {
-        return lve.var->allocaInst;
-        
-        /*llvm::Value* val = builder.CreateLoad(
-            lve.type->getLlvmType(builder.getContext())->getPointerTo(),
-            lve.var->allocaInst
-        );
-        return val;*/
+    if (llvm::dyn_cast<llvm::AllocaInst>(var)) {
+        return var;
     }
-    else if (llvm::dyn_cast<llvm::PointerType> (lve.var->allocaInst->getType())) {
-        return lve.var->allocaInst;
+    else if (llvm::dyn_cast<llvm::PointerType> (var->getType())) {
+        return var;
     }
     else {
         throw "unable to find alloca instance of local variable";
-        //return lve.var->allocaInst;
     }
 }
 
@@ -362,8 +513,14 @@ llvm::Value* LValueVisitor::visit(sem::FieldAccessExpression& access, qlow::gen:
     using llvm::Value;
     using llvm::Type;
     sem::Context& semCtxt = access.context;
+
+    // the field is only a column of an @soa array
+    if (access.isSoaField()) {
+        auto& element = static_cast<sem::ArrayAccessExpression&>(*access.target);
+        return fg.generateSoaFieldAddress(fg.generateSoaElement(element), access.accessed);
+    }
     
-    Type* type = access.target->type->getLlvmType(fg.builder.getContext());
+    Type* type = fg.session.getLlvmType(access.target->type);
     
     if (type == nullptr)
         throw "no access type";
@@ -371,9 +528,13 @@ llvm::Value* LValueVisitor::visit(sem::FieldAccessExpression& access, qlow::gen:
         type = type->getPointerElementType();
     }
     
-    llvm::Value* target = access.target->accept(fg.expressionVisitor, fg.builder);
+    llvm::Value* target;
+    if (access.target->type->isStructType())
+        target = access.target->accept(fg.lvalueVisitor, fg);
+    else
+        target = access.target->accept(fg.expressionVisitor, fg.builder);
     
-    int structIndex = access.accessed->llvmStructIndex;
+    unsigned structIndex = fg.session.getStructIndex(access.accessed);
     /*llvm::ArrayRef<Value*> indexList = {
         llvm::ConstantInt::get(fg.builder.getContext(), llvm::APInt(32, structIndex, false)),
         llvm::ConstantInt::get(fg.builder.getContext(), llvm::APInt(32, 0, false))
@@ -388,22 +549,30 @@ llvm::Value* LValueVisitor::visit(sem::ArrayAccessExpression& node, qlow::gen::F
 {
     auto& builder = fg.builder;
     auto array = node.array->accept(fg.expressionVisitor, builder);
-    auto index = node.index->accept(fg.expressionVisitor, builder);
+    auto index = fg.generateIndex(node.index->accept(fg.expressionVisitor, builder),
+        node.index->type);
 
     auto arrType = node.array->type;
     if (!arrType->isArrayType()) {
         throw "trying to access non-array type as array.";
     }
+    if (arrType->isSoaArrayType()) {
+        throw "internal error: element of an @soa array used as lvalue";
+    }
 
     //auto ostr = llvm::raw_os_ostream(Printer::getInstance());
     //fg.getModule()->print(ostr, nullptr);
 
     auto elemType = arrType->getArrayOf();
+    llvm::Type* arrayStructType = fg.session.getLlvmType(arrType);
 
-    auto arrPtr = builder.CreateStructGEP(arrType->getLlvmType(builder.getContext()), array, 0);
-    // TODO implement range check
-    //auto length = builder.CreateStructGEP(arrType->getLlvmType(builder.getContext()), array, 1);
+    if (node.needsBoundsCheck) {
+        auto lengthPtr = builder.CreateStructGEP(arrayStructType, array, 1);
+        auto length = builder.CreateLoad(builder.getInt64Ty(), lengthPtr);
+        fg.generateBoundsCheck(index, length);
+    }
 
+    auto arrPtr = builder.CreateStructGEP(arrayStructType, array, 0);
     auto arr = builder.CreateLoad(arrPtr);
 
     auto accessVal = builder.CreateGEP(arr, index);
@@ -415,9 +584,22 @@ llvm::Value* LValueVisitor::visit(sem::ArrayAccessExpression& node, qlow::gen::F
 llvm::Value* StatementVisitor::visit(sem::DoEndBlock& block,
         qlow::gen::FunctionGenerator& fg)
 {
+    fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    size_t owned = fg.enterOwnedScope(block);
     for (auto& statement : block.statements) {
         statement->accept(*this, fg);
     }
+    fg.leaveOwnedScope(owned);
+    return nullptr;
+}
+
+
+/// returns the variable if \p expr is an owned local variable
+static const sem::Variable* getOwnedVariable(const sem::Expression* expr)
+{
+    auto* lve = dynamic_cast<const sem::LocalVariableExpression*>(expr);
+    if (lve != nullptr && lve->var->isOwned)
+        return lve->var;
     return nullptr;
 }
 
@@ -430,6 +612,7 @@ llvm::Value* StatementVisitor::visit(sem::IfElseBlock& ifElseBlock,
     
 
     fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(ifElseBlock.pos);
     auto condition = ifElseBlock.condition->accept(fg.expressionVisitor, fg.builder);
     
     llvm::Function* function = fg.getCurrentBlock()->getParent();
@@ -442,16 +625,18 @@ llvm::Value* StatementVisitor::visit(sem::IfElseBlock& ifElseBlock,
     
     fg.builder.CreateCondBr(boolCond, thenB, elseB);  
     
+    // the bodies may end in a different block than they started,
+    // e.g. after a bounds check
     fg.pushBlock(thenB);
     ifElseBlock.ifBlock->accept(*this, fg);
-    fg.builder.SetInsertPoint(thenB);
-    if (!thenB->getTerminator())
+    fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    if (!fg.getCurrentBlock()->getTerminator())
         fg.builder.CreateBr(merge);
     fg.popBlock();
     fg.pushBlock(elseB);
     ifElseBlock.elseBlock->accept(*this, fg);
-    fg.builder.SetInsertPoint(elseB);
-    if (!elseB->getTerminator())
+    fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    if (!fg.getCurrentBlock()->getTerminator())
         fg.builder.CreateBr(merge);
     fg.popBlock();
     fg.popBlock();
@@ -467,6 +652,7 @@ llvm::Value* StatementVisitor::visit(sem::WhileBlock& whileBlock,
     using llvm::BasicBlock;
     
     fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(whileBlock.pos);
     
     llvm::Function* function = fg.getCurrentBlock()->getParent();
     
@@ -486,34 +672,209 @@ llvm::Value* StatementVisitor::visit(sem::WhileBlock& whileBlock,
     
     fg.pushBlock(body);
     whileBlock.body->accept(*this, fg);
-    fg.builder.SetInsertPoint(body);
-    fg.builder.CreateBr(startloop);
+    fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(whileBlock.pos);
+    if (!fg.getCurrentBlock()->getTerminator())
+        fg.builder.CreateBr(startloop);
+    fg.popBlock();
+    fg.pushBlock(merge);
+    return nullptr;
+}
+
+
+/*!
+ * The loop is emitted in the rotated form the loop passes expect: a guard
+ * in front of the loop, and a single latch that increments the induction
+ * variable and compares it with the end. The loop variable is stored from
+ * the induction variable, so the body cannot change the number of
+ * iterations.
+ */
+llvm::Value* StatementVisitor::visit(sem::ForBlock& forBlock,
+        qlow::gen::FunctionGenerator& fg)
+{
+    using llvm::Value;
+    using llvm::BasicBlock;
+
+    auto& builder = fg.builder;
+    builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(forBlock.pos);
+
+    llvm::Function* function = fg.getCurrentBlock()->getParent();
+    llvm::LLVMContext& context = fg.getContext();
+
+    Value* start;
+    Value* end;
+    Value* elements = nullptr;
+    llvm::Type* elementType = nullptr;
+    bool isSigned = true;
+    if (forBlock.array) {
+        // the elements pointer and the length are loaded only once
+        Value* array = forBlock.array->accept(fg.expressionVisitor, builder);
+        llvm::Type* arrayStructType = fg.session.getLlvmType(forBlock.array->type);
+        elements = builder.CreateLoad(arrayStructType->getStructElementType(0),
+            builder.CreateStructGEP(arrayStructType, array, 0), "elements");
+        end = builder.CreateLoad(builder.getInt64Ty(),
+            builder.CreateStructGEP(arrayStructType, array, 1), "length");
+        elementType = fg.session.getLlvmType(forBlock.variable->type);
+        start = builder.getInt64(0);
+    }
+    else {
+        start = forBlock.from->accept(fg.expressionVisitor, builder);
+        end = forBlock.to->accept(fg.expressionVisitor, builder);
+        isSigned = !static_cast<sem::NativeType*>(forBlock.from->type)->isUnsignedType();
+    }
+
+    BasicBlock* preheader = builder.GetInsertBlock();
+    BasicBlock* body = BasicBlock::Create(context, "forbody", function);
+    BasicBlock* merge = BasicBlock::Create(context, "merge", function);
+
+    Value* enter = isSigned ? builder.CreateICmpSLT(start, end) : builder.CreateICmpULT(start, end);
+    builder.CreateCondBr(enter, body, merge);
+
+    fg.pushBlock(body);
+    builder.SetInsertPoint(body);
+    llvm::PHINode* index = builder.CreatePHI(start->getType(), 2, forBlock.variable->name);
+    index->addIncoming(start, preheader);
+
+    Value* value = index;
+    if (elements != nullptr && forBlock.array->type->isSoaArrayType())
+        value = fg.generateSoaLoad({ forBlock.variable->type, elements, end, index });
+    else if (elements != nullptr)
+        value = builder.CreateLoad(elementType, builder.CreateGEP(elementType, elements, index));
+    builder.CreateStore(value, fg.session.getVariable(forBlock.variable));
+
+    forBlock.body->accept(*this, fg);
+    builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(forBlock.pos);
+    if (!fg.getCurrentBlock()->getTerminator()) {
+        // the index is smaller than the end, so the increment cannot overflow
+        Value* next = builder.CreateAdd(index, llvm::ConstantInt::get(index->getType(), 1),
+            forBlock.variable->name + ".next", !isSigned, isSigned);
+        Value* condition = isSigned ? builder.CreateICmpSLT(next, end) : builder.CreateICmpULT(next, end);
+        llvm::BranchInst* latch = builder.CreateCondBr(condition, body, merge);
+        index->addIncoming(next, fg.getCurrentBlock());
+
+        llvm::MDNode* mustProgress = llvm::MDNode::get(context,
+            llvm::MDString::get(context, "llvm.loop.mustprogress"));
+        llvm::MDNode* loopId = llvm::MDNode::getDistinct(context, { nullptr, mustProgress });
+        loopId->replaceOperandWith(0, loopId);
+        latch->setMetadata(llvm::LLVMContext::MD_loop, loopId);
+    }
+    fg.popBlock();
+    fg.pushBlock(merge);
+    return nullptr;
+}
+
+
+llvm::Value* StatementVisitor::visit(sem::MatchBlock& matchBlock,
+        qlow::gen::FunctionGenerator& fg)
+{
+    using llvm::BasicBlock;
+
+    auto& builder = fg.builder;
+    builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(matchBlock.pos);
+
+    llvm::Function* function = fg.getCurrentBlock()->getParent();
+    llvm::LLVMContext& context = fg.getContext();
+
+    llvm::Value* value = matchBlock.value->accept(fg.expressionVisitor, builder);
+    auto* type = llvm::cast<llvm::IntegerType>(value->getType());
+
+    BasicBlock* defaultBlock = BasicBlock::Create(context, "matchelse", function);
+    BasicBlock* merge = BasicBlock::Create(context, "merge", function);
+    llvm::SwitchInst* switchInst = builder.CreateSwitch(value, defaultBlock,
+        matchBlock.cases.size());
+
+    auto generateCase = [&] (BasicBlock* block, sem::DoEndBlock& body) {
+        fg.pushBlock(block);
+        body.accept(*this, fg);
+        builder.SetInsertPoint(fg.getCurrentBlock());
+        if (!fg.getCurrentBlock()->getTerminator())
+            builder.CreateBr(merge);
+        fg.popBlock();
+    };
+
+    for (auto& c : matchBlock.cases) {
+        BasicBlock* block = BasicBlock::Create(context, "case", function);
+        for (unsigned long long v : c.values)
+            switchInst->addCase(llvm::ConstantInt::get(type, v), block);
+        generateCase(block, *c.body);
+    }
+
+    // without an else branch, the cases cover all values that can occur
+    if (matchBlock.elseBlock) {
+        generateCase(defaultBlock, *matchBlock.elseBlock);
+    }
+    else {
+        builder.SetInsertPoint(defaultBlock);
+        builder.CreateUnreachable();
+    }
+
     fg.popBlock();
     fg.pushBlock(merge);
     return nullptr;
 }
 
 
+llvm::Value* StatementVisitor::visit(sem::RegionBlock& regionBlock,
+        qlow::gen::FunctionGenerator& fg)
+{
+    fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(regionBlock.pos);
+    fg.enterRegion();
+    regionBlock.body->accept(*this, fg);
+    fg.leaveRegion();
+    return nullptr;
+}
+
+
 llvm::Value* StatementVisitor::visit(sem::AssignmentStatement& assignment,
         qlow::gen::FunctionGenerator& fg)
 {
     Printer& printer = Printer::getInstance();
     fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(assignment.pos);
     
     auto val = assignment.value->accept(fg.expressionVisitor, fg.builder);
+
+    // elements of @soa arrays are scattered into the columns
+    if (auto* element = dynamic_cast<sem::ArrayAccessExpression*>(assignment.target.get());
+        element != nullptr && element->array->type->isSoaArrayType()) {
+        fg.generateSoaStore(fg.generateSoaElement(*element), val);
+        return nullptr;
+    }
+
     auto target = assignment.target->accept(fg.lvalueVisitor, fg);
-    
-    if (!assignment.value->type->isNativeType() && !assignment.value->type->isReferenceType()) {
+
+    // an owned variable frees its object when it gets a new one, and
+    // assigning one owned variable to another moves the object
+    const sem::Variable* owner = getOwnedVariable(assignment.target.get());
+    const sem::Variable* moved = getOwnedVariable(assignment.value.get());
+    if (owner != nullptr && owner != moved)
+        fg.freeOwnedObject(owner);
+
+    // arrays evaluate to a pointer to their { elements, length } struct,
+    // all other values are stored directly
+    llvm::Value* result;
+    if (assignment.value->type->isArrayType()) {
         const llvm::DataLayout& layout = fg.builder.GetInsertBlock()->getModule()->getDataLayout();
 #if LLVM_VERSION_MAJOR >= 7
-        return fg.builder.CreateMemCpy(target, llvm::MaybeAlign(), val, llvm::MaybeAlign(), layout.getTypeAllocSize(val->getType()->getPointerElementType()), false);
+        result = fg.builder.CreateMemCpy(target, llvm::MaybeAlign(), val, llvm::MaybeAlign(), layout.getTypeAllocSize(val->getType()->getPointerElementType()), false);
 #else
-        return fg.builder.CreateMemCpy(target, val, layout.getTypeAllocSize(val->getType()->getPointerElementType()), 1);
+        result = fg.builder.CreateMemCpy(target, val, layout.getTypeAllocSize(val->getType()->getPointerElementType()), 1);
 #endif
     }
+    else if (auto* field = dynamic_cast<sem::FieldAccessExpression*>(assignment.target.get())) {
+        result = fg.builder.CreateAlignedStore(val, target, getFieldAlignment(*field));
+    }
     else {
-        return fg.builder.CreateStore(val, target);
+        result = fg.builder.CreateStore(val, target);
     }
+
+    if (owner != nullptr && moved != nullptr && owner != moved)
+        fg.clearVariable(moved);
+    return result;
     
     /*
     if (auto* targetVar =
@@ -557,22 +918,61 @@ llvm::Value* StatementVisitor::visit(sem::ReturnStatement& returnStatement,
         qlow::gen::FunctionGenerator& fg)
 {
     fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(returnStatement.pos);
+    if (auto* call = dynamic_cast<sem::MethodCallExpression*>(returnStatement.value.get());
+        call != nullptr && call->tailCall == sem::MethodCallExpression::TailCall::LOOP) {
+        fg.generateTailRecursion(*call);
+        return nullptr;
+    }
     auto val = returnStatement.value->accept(fg.expressionVisitor, fg.builder);
     if (returnStatement.value != nullptr && val == nullptr) {
         throw "internal error: returned type is invalid";
     }
+    // the returned value is computed before the owned objects and the
+    // regions are freed. A returned owned variable moves its object out.
+    fg.freeOwnedObjects(getOwnedVariable(returnStatement.value.get()));
+    fg.leaveAllRegions();
+    if (llvm::Value* returnSlot = fg.getReturnSlot(); returnSlot != nullptr) {
+        fg.builder.CreateStore(val, returnSlot);
+        fg.builder.CreateRetVoid();
+        return val;
+    }
     fg.builder.CreateRet(val);
     return val;
 }
 
 
+llvm::Value* StatementVisitor::visit(sem::DeleteStatement& deleteStatement,
+        qlow::gen::FunctionGenerator& fg)
+{
+    fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(deleteStatement.pos);
+    llvm::Value* object = deleteStatement.value->accept(fg.expressionVisitor, fg.builder);
+    fg.generateDelete(object, deleteStatement.value->type);
+    // an owned variable must not free the object again
+    if (const sem::Variable* owner = getOwnedVariable(deleteStatement.value.get()))
+        fg.clearVariable(owner);
+    return nullptr;
+}
+
+
 llvm::Value* StatementVisitor::visit(sem::FeatureCallStatement& fc, gen::FunctionGenerator& fg)
 {
     llvm::Module* module = fg.getModule();
     fg.builder.SetInsertPoint(fg.getCurrentBlock());
+    fg.setDebugLocation(fc.pos);
     //llvm::Constant* c = module->getOrInsertFunction(fc.expr->callee->name, {});
-    
-    return fc.expr->accept(fg.expressionVisitor, fg.builder);
+
+    // calls in tail position are only followed by the return
+    using TailCall = sem::MethodCallExpression::TailCall;
+    if (fc.expr->tailCall == TailCall::LOOP) {
+        fg.generateTailRecursion(*fc.expr);
+        return nullptr;
+    }
+    llvm::Value* result = fc.expr->accept(fg.expressionVisitor, fg.builder);
+    if (fc.expr->tailCall != TailCall::NONE)
+        fg.builder.CreateRetVoid();
+    return result;
     
     /*
     llvm::Function* f = fc.expr->callee->llvmNode;
@@ -49,6 +49,7 @@ class qlow::ExpressionCodegenVisitor :
         sem::AddressExpression,
         sem::ArrayAccessExpression,
         sem::IntConst,
+        sem::FloatConst,
         sem::ThisExpression
     >
 {
@@ -70,6 +71,7 @@ public:
     llvm::Value* visit(sem::AddressExpression& node, llvm::IRBuilder<>&) override;
     llvm::Value* visit(sem::ArrayAccessExpression& node, llvm::IRBuilder<>&) override;
     llvm::Value* visit(sem::IntConst& node, llvm::IRBuilder<>&) override;
+    llvm::Value* visit(sem::FloatConst& node, llvm::IRBuilder<>&) override;
     llvm::Value* visit(sem::ThisExpression& node, llvm::IRBuilder<>&) override;
 };
 
@@ -101,8 +103,12 @@ class qlow::StatementVisitor :
         sem::DoEndBlock,
         sem::IfElseBlock,
         sem::WhileBlock,
+        sem::ForBlock,
+        sem::MatchBlock,
+        sem::RegionBlock,
         sem::AssignmentStatement,
         sem::ReturnStatement,
+        sem::DeleteStatement,
         sem::FeatureCallStatement
     >
 {
@@ -110,8 +116,12 @@ public:
     llvm::Value* visit(sem::DoEndBlock& node, gen::FunctionGenerator&) override;
     llvm::Value* visit(sem::IfElseBlock& node, gen::FunctionGenerator&) override;
     llvm::Value* visit(sem::WhileBlock& node, gen::FunctionGenerator&) override;
+    llvm::Value* visit(sem::ForBlock& node, gen::FunctionGenerator&) override;
+    llvm::Value* visit(sem::MatchBlock& node, gen::FunctionGenerator&) override;
+    llvm::Value* visit(sem::RegionBlock& node, gen::FunctionGenerator&) override;
     llvm::Value* visit(sem::AssignmentStatement& node, gen::FunctionGenerator&) override;
     llvm::Value* visit(sem::ReturnStatement& node, gen::FunctionGenerator&) override;
+    llvm::Value* visit(sem::DeleteStatement& node, gen::FunctionGenerator&) override;
     llvm::Value* visit(sem::FeatureCallStatement& node, gen::FunctionGenerator&) override;
 };
 
@@ -30,6 +30,16 @@ Options Options::parseOptions(int argc, char** argv)
         {"--emit-assembly", &Options::emitAssembly},
         {"-L",              &Options::emitLlvm},
         {"--emit-llvm",     &Options::emitLlvm},
+        {"-fno-inline",     &Options::noInline},
+        {"--static",        &Options::staticLink},
+        {"--print-pipeline", &Options::printPipeline},
+        {"--print-layouts", &Options::printLayouts},
+        {"-ffast-math",     &Options::fastMath},
+        {"-fassociative-math", &Options::associativeMath},
+        {"-freciprocal-math", &Options::reciprocalMath},
+        {"-ffinite-math-only", &Options::finiteMath},
+        {"-fno-signed-zeros", &Options::noSignedZeros},
+        {"-fsave-optimization-record", &Options::saveOptimizationRecord},
     };
     
     Options options{};
@@ -48,6 +58,10 @@ Options Options::parseOptions(int argc, char** argv)
                 throw "Please specify a filename after '-o'";
             }
         }
+        else if (arg == "-Os" || arg == "-Oz") {
+            options.optLevel = 2;
+            options.sizeLevel = arg == "-Os" ? 1 : 2;
+        }
         else if (arg.rfind("-O", 0) == 0) {
             if (arg.size() > 2) {
                 options.optLevel = std::stoi(arg.substr(2));
@@ -56,6 +70,102 @@ Options Options::parseOptions(int argc, char** argv)
                 options.optLevel = 2;
             }
         }
+        else if (arg.rfind("--passes=", 0) == 0) {
+            options.passes = arg.substr(arg.find('=') + 1);
+        }
+        else if (arg.rfind("--passes-ep-", 0) == 0 && arg.find('=') != std::string::npos) {
+            size_t equals = arg.find('=');
+            std::string point = arg.substr(12, equals - 12);
+            options.extensionPipelines[point] = arg.substr(equals + 1);
+        }
+        else if (arg.rfind("--symbol-ordering-file=", 0) == 0) {
+            options.symbolOrderingFile = arg.substr(arg.find('=') + 1);
+        }
+        else if (arg.rfind("--bounds-checks=", 0) == 0) {
+            static const std::map<std::string, BoundsChecks> modes = {
+                { "on",     BoundsChecks::ON },
+                { "off",    BoundsChecks::OFF },
+                { "trap",   BoundsChecks::TRAP },
+            };
+            auto mode = modes.find(arg.substr(arg.find('=') + 1));
+            if (mode != modes.end()) {
+                options.boundsChecks = mode->second;
+            }
+            else {
+                throw "Please specify 'on', 'off' or 'trap' after '--bounds-checks='";
+            }
+        }
+        else if (arg.rfind("--field-layout=", 0) == 0) {
+            static const std::map<std::string, FieldLayout> modes = {
+                { "declaration",    FieldLayout::DECLARATION },
+                { "optimized",      FieldLayout::OPTIMIZED },
+            };
+            auto mode = modes.find(arg.substr(arg.find('=') + 1));
+            if (mode != modes.end()) {
+                options.fieldLayout = mode->second;
+            }
+            else {
+                throw "Please specify 'declaration' or 'optimized' after '--field-layout='";
+            }
+        }
+        else if (arg.rfind("-ffp-contract=", 0) == 0) {
+            std::string mode = arg.substr(arg.find('=') + 1);
+            if (mode == "fast" || mode == "off") {
+                options.fpContract = mode == "fast";
+            }
+            else {
+                throw "Please specify 'fast' or 'off' after '-ffp-contract='";
+            }
+        }
+        else if (arg == "-flto" || arg.rfind("-flto=", 0) == 0) {
+            static const std::map<std::string, Lto> modes = {
+                { "-flto",      Lto::FULL },
+                { "-flto=full", Lto::FULL },
+                { "-flto=thin", Lto::THIN },
+            };
+            auto mode = modes.find(arg);
+            if (mode != modes.end()) {
+                options.lto = mode->second;
+            }
+            else {
+                throw "Please specify 'thin' or 'full' after '-flto='";
+            }
+        }
+        else if (arg.rfind("-Rpass=", 0) == 0) {
+            options.passRemarks = arg.substr(arg.find('=') + 1);
+        }
+        else if (arg == "-Rpass-missed") {
+            options.missedRemarks = ".*";
+        }
+        else if (arg.rfind("-Rpass-missed=", 0) == 0) {
+            options.missedRemarks = arg.substr(arg.find('=') + 1);
+        }
+        else if (arg.rfind("-Rpass-analysis=", 0) == 0) {
+            options.analysisRemarks = arg.substr(arg.find('=') + 1);
+        }
+        else if (arg == "-g") {
+            options.debugInfo = DebugInfo::FULL;
+        }
+        else if (arg == "-gline-tables-only") {
+            options.debugInfo = DebugInfo::LINE_TABLES_ONLY;
+        }
+        else if (arg == "-g0") {
+            options.debugInfo = DebugInfo::NONE;
+        }
+        else if (arg == "-fprofile-generate") {
+            options.profileGenerate = true;
+        }
+        else if (arg.rfind("-fprofile-use=", 0) == 0) {
+            options.profileUse = arg.substr(arg.find('=') + 1);
+        }
+        else if (arg.rfind("-march=", 0) == 0 || arg.rfind("-mcpu=", 0) == 0) {
+            options.targetCpu = arg.substr(arg.find('=') + 1);
+        }
+        else if (arg.rfind("-mattr=", 0) == 0) {
+            if (!options.targetFeatures.empty())
+                options.targetFeatures += ",";
+            options.targetFeatures += arg.substr(arg.find('=') + 1);
+        }
         else if (arg.rfind("-l", 0) == 0) {
             if (arg.size() > 2) {
                 options.libs.push_back(arg.substr(2));
@@ -69,6 +179,13 @@ Options Options::parseOptions(int argc, char** argv)
     }
     if (options.outfile == "")
         options.outfile = "a.out";
+    if (options.fastMath) {
+        options.associativeMath = true;
+        options.reciprocalMath = true;
+        options.finiteMath = true;
+        options.noSignedZeros = true;
+        options.fpContract = true;
+    }
     return options;
 }
 
@@ -135,10 +252,13 @@ int Driver::run(void) try
     printer << "starting code generation!" << std::endl;
 #endif
 
+    // the session owns the llvm context and must outlive the module
+    qlow::gen::CodegenSession session{ options };
     std::unique_ptr<llvm::Module> mod = nullptr;
     
     try {
-        mod = qlow::gen::generateModule(*semClasses);
+        mod = qlow::gen::generateModule(session, *semClasses);
+        freestanding = session.isFreestanding();
     }
     catch (const char* err) {
         reportError(err);
@@ -156,8 +276,12 @@ int Driver::run(void) try
     // TODO create better tempfile
     tempObject = "/tmp/temp.o";
 
+    // llvm ir and assembly are written to the output file directly
+    bool link = !options.emitLlvm && !options.emitAssembly;
+
     try {
-        qlow::gen::generateObjectFile(tempObject, std::move(mod), options.optLevel);
+        qlow::gen::generateObjectFile(link ? tempObject.string() : options.outfile,
+            std::move(mod), options);
     }
     catch (const char* msg) {
         printError(printer, msg);
@@ -173,9 +297,16 @@ int Driver::run(void) try
     printer << "object exported!" << std::endl;
 #endif
 
+    if (!link)
+        return 0;
+
     try {
         linkingStage();
     }
+    catch (const char* msg) {
+        reportError(msg);
+        return 1;
+    }
     catch (...) {
         reportError("unknown error during linking");
         return 1;
@@ -279,17 +410,64 @@ bool Driver::linkingStage(void)
 {
     using namespace std::literals;
     bool errorOccurred = false;
-    auto linkerPath = qlow::getLinkerExecutable();
+
+    // the startup files of the static C library are only known to the C
+    // compiler, so it is used as linker driver in that case
+    bool viaCompiler = options.staticLink && !freestanding;
+    std::string linkerPath;
+    if (viaCompiler)
+        linkerPath = qlow::getCCompilerExecutable();
+    else if (options.lto == Options::Lto::NONE)
+        linkerPath = qlow::getLinkerExecutable();
+    else
+        linkerPath = qlow::getLtoLinkerExecutable();
+
+    auto linkerOption = [viaCompiler] (const std::string& option) {
+        return viaCompiler ? "-Wl," + option : option;
+    };
 
     std::vector<std::string> ldArgs = {
-        tempObject.string(), "-e", "_qlow_start", "-o", options.outfile,
-        "-lc",
+        tempObject.string(), "-o", options.outfile,
+    };
+
+    if (freestanding) {
+        // the module contains its own runtime, so no startup files and no
+        // dynamic loader are needed
+        ldArgs.insert(ldArgs.end(), { "-static", "-e", "_qlow_start", "--gc-sections" });
+    }
+    else if (options.staticLink) {
+        ldArgs.push_back("-static");
+        if (options.lto != Options::Lto::NONE)
+            ldArgs.push_back("-fuse-ld=lld");
+    }
+    else {
+        ldArgs.insert(ldArgs.end(), {
+            "-e", "_qlow_start", "-lc",
 #ifdef __linux__
-        "-dynamic-linker", "/lib64/ld-linux-x86-64.so.2"
+            "-dynamic-linker", "/lib64/ld-linux-x86-64.so.2"
 #endif
-    };
+        });
+    }
+
+    for (const auto& lib : options.libs)
+        ldArgs.push_back("-l" + lib);
+
+    // every function is emitted into its own section, so the linker can
+    // reorder them (supported by lld and gold)
+    if (!options.symbolOrderingFile.empty())
+        ldArgs.push_back(linkerOption("--symbol-ordering-file=" + options.symbolOrderingFile));
 
-    std::copy(options.libs.begin(), options.libs.end(), std::back_inserter(ldArgs));
+    // the bitcode is optimized again and compiled by the linker, together
+    // with bitcode in the libraries. The target cpu is taken from the
+    // function attributes.
+    if (options.lto != Options::Lto::NONE) {
+        ldArgs.push_back(linkerOption("--lto-O" + std::to_string(std::min(options.optLevel, 3))));
+    }
+
+    // the profile runtime has to come after the object that uses it
+    if (options.profileGenerate) {
+        ldArgs.push_back(qlow::getProfileRuntimeLibrary());
+    }
 
     int linkerRun = qlow::invokeProgram(linkerPath, ldArgs);
 
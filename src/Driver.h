@@ -2,6 +2,7 @@
 #define QLOW_DRIVER_H
 
 #include <vector>
+#include <map>
 #include <optional>
 #include <memory>
 #include <string>
@@ -29,13 +30,103 @@ namespace qlow
 
 struct qlow::Options
 {
+    /// write assembly to the output file instead of linking
     bool emitAssembly;
+    /// write the optimized llvm ir to the output file instead of linking,
+    /// and the ir before optimization to a <code>.unoptimized.ll</code> file
     bool emitLlvm;
+    /// only inline functions annotated with <code>@always_inline</code>
+    bool noInline;
     std::string outfile = "a.out";
     std::vector<std::string> infiles;
     std::vector<std::string> libs;
+    /// file listing symbols in the order the linker should place them
+    std::string symbolOrderingFile;
+    /// link a static executable. Programs that do not need the C library
+    /// are linked without it and exit using system calls.
+    bool staticLink;
+
+    enum class BoundsChecks
+    {
+        ON,     ///< report out of range array accesses and exit
+        OFF,    ///< do not check array accesses
+        TRAP,   ///< execute a trap instruction on out of range accesses
+    };
+    BoundsChecks boundsChecks = BoundsChecks::ON;
+
+    enum class FieldLayout
+    {
+        DECLARATION,    ///< place fields in the order they are declared
+        OPTIMIZED,      ///< sort fields by alignment to avoid padding
+    };
+    FieldLayout fieldLayout = FieldLayout::DECLARATION;
+    /// print the size, the field offsets and the padding of every class
+    bool printLayouts;
+
+    /// enables all of the floating point relaxations below
+    bool fastMath;
+    /// allow reassociating floating point operations, e.g. in reductions
+    bool associativeMath;
+    /// allow replacing divisions by multiplications with the reciprocal
+    bool reciprocalMath;
+    /// assume that no floating point operation results in NaN or infinity
+    bool finiteMath;
+    /// ignore the sign of floating point zeros
+    bool noSignedZeros;
+    /// allow fusing multiplications and additions into fma instructions
+    bool fpContract;
+
+    /// cpu to generate code for, empty for a generic cpu, "native" for the host
+    std::string targetCpu;
+    /// comma separated list of target features like "+avx2,-fma"
+    std::string targetFeatures;
     
+    enum class Lto
+    {
+        NONE,   ///< emit machine code
+        THIN,   ///< emit bitcode with a summary for ThinLTO
+        FULL,   ///< emit bitcode, the linker optimizes all modules together
+    };
+    Lto lto = Lto::NONE;
+
+    /// instrument the program to write an execution profile when it exits
+    bool profileGenerate;
+    /// merged profile (<code>llvm-profdata merge</code>) to optimize with
+    std::string profileUse;
+
+    enum class DebugInfo
+    {
+        NONE,               ///< no debug information
+        LINE_TABLES_ONLY,   ///< functions and line tables, for profilers
+        FULL,               ///< also variables and types
+    };
+    DebugInfo debugInfo = DebugInfo::NONE;
+
     int optLevel = 0;
+    /// 1 for <code>-Os</code>, 2 for <code>-Oz</code>
+    int sizeLevel = 0;
+
+    /// textual pass pipeline replacing the default one, e.g. "function(sroa,instcombine)"
+    std::string passes;
+    /// print the optimization pipeline before running it
+    bool printPipeline;
+    /// function pass pipelines to insert at the extension points of the
+    /// default pipeline, by the name of the point (e.g. "peephole")
+    std::map<std::string, std::string> extensionPipelines;
+    
+    /// regular expressions selecting the passes whose optimization
+    /// remarks are printed, empty to print none
+    std::string passRemarks;
+    std::string missedRemarks;
+    std::string analysisRemarks;
+    /// write all optimization remarks to a <code>.opt.yaml</code> file
+    bool saveOptimizationRecord;
+
+    inline bool hasRemarks(void) const
+    {
+        return !passRemarks.empty() || !missedRemarks.empty() ||
+            !analysisRemarks.empty() || saveOptimizationRecord;
+    }
     
     static Options parseOptions(int argc, char** argv);
 };
@@ -49,6 +140,8 @@ class qlow::Driver
     std::unique_ptr<sem::GlobalScope> semClasses = nullptr;
 
     qlow::util::Path tempObject = "";
+    /// set if the generated object does not need the C library
+    bool freestanding = false;
 public:
     Driver(void) = delete;
     Driver(int argc, char** argv);
@@ -48,6 +48,18 @@ namespace qlow
     }
 
 
+    void printRemark(Printer& printer, const std::string& msg, const CodePosition& cp) noexcept
+    {
+        printer.bold();
+        if (!cp.filename.empty())
+            printer << cp.getReportFormat() << ": ";
+        printer.foreground(Printer::BLUE, true);
+        printer << "remark: ";
+        printer.removeFormatting();
+        printer << msg << std::endl;
+    }
+
+
     void printError(ErrorCode ec, Printer& printer) noexcept
     {
         static const std::map<ErrorCode, std::string> error = {
@@ -219,6 +231,12 @@ std::string SemanticError::getMessage(void) const noexcept
         {OPERATOR_NOT_FOUND, ""},
         {WRONG_NUMBER_OF_ARGUMENTS, "wrong number of arguments passed"},
         {INVALID_RETURN_TYPE, "invalid return type"},
+        {INVALID_ANNOTATION, "invalid annotation"},
+        {NO_TAIL_CALL, "call cannot be made a tail call"},
+        {DUPLICATE_CASE, "duplicate case"},
+        {NON_EXHAUSTIVE_MATCH, "match does not handle all values"},
+        {USE_AFTER_FREE, "use of a freed object"},
+        {OWNED_OUTLIVES_REGION, "object of a region assigned to an owned variable outside of it"},
         {NO_MAIN_METHOD, "no main method specified"},
     };
     if (errors.find(errorCode) != errors.end())
@@ -26,6 +26,8 @@ namespace qlow
     void reportError(const std::string& message) noexcept;
     void printError(Printer& printer, const std::string& message) noexcept;
     void printError(Printer& printer, const std::string& message, const CodePosition& where) noexcept;
+    /// prints a note from the optimizer, \p where may be \ref CodePosition::none
+    void printRemark(Printer& printer, const std::string& message, const CodePosition& where) noexcept;
 
     void printError(ErrorCode ec, Printer& printer) noexcept;
 }
@@ -134,6 +136,12 @@ public:
         TYPE_MISMATCH,
         INVALID_RETURN_TYPE,
         NEW_FOR_NON_CLASS,
+        INVALID_ANNOTATION,
+        NO_TAIL_CALL,
+        DUPLICATE_CASE,
+        NON_EXHAUSTIVE_MATCH,
+        USE_AFTER_FREE,
+        OWNED_OUTLIVES_REGION,
 
         NO_MAIN_METHOD,
     };
@@ -27,6 +27,28 @@ std::string qlow::getLinkerExecutable(void)
 }
 
 
+std::string qlow::getLtoLinkerExecutable(void)
+{
+    return "ld.lld";
+}
+
+
+std::string qlow::getCCompilerExecutable(void)
+{
+    return "cc";
+}
+
+
+std::string qlow::getProfileRuntimeLibrary(void)
+{
+#ifdef QLOW_PROFILE_RUNTIME
+    return QLOW_PROFILE_RUNTIME;
+#else
+    throw "no profile runtime available, please install compiler-rt and reconfigure qlow";
+#endif
+}
+
+
 int qlow::invokeProgram(const std::string& path, const std::vector<std::string>& args)
 {
 #ifdef _WIN32
@@ -8,6 +8,12 @@ namespace qlow
 {
     std::string getExternalSymbol(const std::string& name);
     std::string getLinkerExecutable(void);
+    /// returns a linker that can optimize llvm bitcode objects
+    std::string getLtoLinkerExecutable(void);
+    /// returns the C compiler, which links against the static C library
+    std::string getCCompilerExecutable(void);
+    /// returns the path of the runtime library for <code>-fprofile-generate</code>
+    std::string getProfileRuntimeLibrary(void);
     int invokeProgram(const std::string& path, const std::vector<std::string>& args);
 }
 
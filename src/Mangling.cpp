@@ -3,6 +3,9 @@
 #include "Type.h"
 
 
+static const std::string prefix = "_Q";
+
+
 std::string numberEncode(const std::string& x)
 {
     return std::to_string(x.length()) + x;
@@ -11,8 +14,6 @@ std::string numberEncode(const std::string& x)
 
 std::string qlow::mangle(const qlow::sem::Method& method)
 {
-    static const std::string prefix = "_Q";
-
     std::string mangled = prefix;
     sem::Class* parent = method.containingClass;
 
@@ -35,6 +36,9 @@ std::string qlow::mangle(const qlow::sem::Type* type)
     if (type->isClassType()) {
         return "C" + numberEncode(type->getClass()->name);
     }
+    else if (type->isSoaArrayType()) {
+        return "S" + mangle(type->getArrayOf());
+    }
     else if (type->isArrayType()) {
         return "A" + mangle(type->getArrayOf());
     }
@@ -45,4 +49,7 @@ std::string qlow::mangle(const qlow::sem::Type* type)
 }
 
 
-
+bool qlow::isMangledName(const std::string& symbol)
+{
+    return symbol.compare(0, prefix.size(), prefix) == 0;
+}
@@ -17,6 +17,9 @@ namespace qlow
 
     std::string mangle(const sem::Method& method);
     std::string mangle(const sem::Type* type);
+
+    /// checks if \p symbol is the mangled name of a method
+    bool isMangledName(const std::string& symbol);
 }
 
 
@@ -4,6 +4,7 @@
 #include "Type.h"
 #include "Builtin.h"
 #include "Context.h"
+#include "ErrorReporting.h"
 
 using namespace qlow;
 
@@ -46,6 +47,17 @@ sem::Method* sem::GlobalScope::getMethod(const std::string& name)
 }
 
 
+/// the columns of <code>@soa</code> arrays hold the fields of struct elements
+static sem::Type* getArrayType(sem::Context& context, sem::Type* elementType,
+    const ast::ArrayType& ast)
+{
+    if (ast.soa && (elementType == nullptr || !elementType->isStructType()))
+        throw SemanticError(SemanticError::INVALID_ANNOTATION,
+            "'@soa' needs an array of structs", ast.pos);
+    return context.getArrayType(elementType, ast.soa);
+}
+
+
 sem::Type* sem::GlobalScope::getType(const ast::Type* name)
 {
     if (name == nullptr) {
@@ -53,7 +65,7 @@ sem::Type* sem::GlobalScope::getType(const ast::Type* name)
     }
 
     if (const auto* arr = dynamic_cast<const ast::ArrayType*>(name); arr) {
-        return context.getArrayType(getType(arr->arrayType.get()));
+        return getArrayType(context, getType(arr->arrayType.get()), *arr);
     }
     
     /*if (const auto* ptr = dynamic_cast<const ast::PointerType*>(name)) {
@@ -104,7 +116,7 @@ sem::Type* sem::NativeScope::getType(const ast::Type* name)
         return context.getVoidType();
     }
     if (const auto* arr = dynamic_cast<const ast::ArrayType*>(name); arr) {
-        return context.getArrayType(getType(arr->arrayType.get()));
+        return getArrayType(context, getType(arr->arrayType.get()), *arr);
     }
     
     const auto* classType = dynamic_cast<const ast::ClassType*>(name);
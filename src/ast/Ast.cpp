@@ -47,14 +47,19 @@ ACCEPT_DEFINITION(Statement, StructureVisitor)
 ACCEPT_DEFINITION(DoEndBlock, StructureVisitor)
 ACCEPT_DEFINITION(IfElseBlock, StructureVisitor)
 ACCEPT_DEFINITION(WhileBlock, StructureVisitor)
+ACCEPT_DEFINITION(ForBlock, StructureVisitor)
+ACCEPT_DEFINITION(MatchBlock, StructureVisitor)
+ACCEPT_DEFINITION(RegionBlock, StructureVisitor)
 ACCEPT_DEFINITION(Expression, StructureVisitor)
 ACCEPT_DEFINITION(FeatureCall, StructureVisitor)
 ACCEPT_DEFINITION(AssignmentStatement, StructureVisitor)
 ACCEPT_DEFINITION(ReturnStatement, StructureVisitor)
+ACCEPT_DEFINITION(DeleteStatement, StructureVisitor)
 ACCEPT_DEFINITION(LocalVariableStatement, StructureVisitor)
 ACCEPT_DEFINITION(AddressExpression, StructureVisitor)
 ACCEPT_DEFINITION(ArrayAccessExpression, StructureVisitor)
 ACCEPT_DEFINITION(IntConst, StructureVisitor)
+ACCEPT_DEFINITION(FloatConst, StructureVisitor)
 ACCEPT_DEFINITION(StringConst, StructureVisitor)
 ACCEPT_DEFINITION(UnaryOperation, StructureVisitor)
 ACCEPT_DEFINITION(BinaryOperation, StructureVisitor)
@@ -75,6 +80,13 @@ qlow::ast::IntConst::IntConst(const std::string& val, const qlow::CodePosition&
 {
 }
 
+qlow::ast::FloatConst::FloatConst(const std::string& val, const qlow::CodePosition& p) :
+    AstObject{ p },
+    Expression{ p },
+    value{ strtod(val.c_str(), nullptr) }
+{
+}
+
 std::unique_ptr<qlow::sem::SemanticObject> qlow::ast::Type::accept(StructureVisitor&, sem::Scope&)
 {
     return nullptr;
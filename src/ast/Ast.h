@@ -46,6 +46,7 @@ namespace qlow
         struct AstObject;
 
         struct ImportDeclaration;
+        struct Annotation;
 
         struct Class;
 
@@ -67,17 +68,23 @@ namespace qlow
         struct DoEndBlock;
         struct IfElseBlock;
         struct WhileBlock;
+        struct ForBlock;
+        struct MatchCase;
+        struct MatchBlock;
+        struct RegionBlock;
 
         struct Expression;
 
         struct FeatureCall;
         struct AssignmentStatement;
         struct ReturnStatement;
+        struct DeleteStatement;
         struct LocalVariableStatement;
         struct AddressExpression;
         struct ArrayAccessExpression;
 
         struct IntConst;
+        struct FloatConst;
         struct StringConst;
 
         struct Operation;
@@ -141,6 +148,32 @@ struct qlow::ast::ImportDeclaration
 };
 
 
+///
+/// \brief an annotation like <code>@noinline</code> or
+///        <code>@align(16)</code> attached to a declaration
+///
+struct qlow::ast::Annotation
+{
+    CodePosition pos;
+    std::string name;
+    std::vector<std::string> arguments;
+
+    inline Annotation(std::string name, const CodePosition& cp) :
+        pos{ cp },
+        name{ std::move(name) }
+    {
+    }
+
+    inline Annotation(std::string name, std::vector<std::string>&& arguments,
+            const CodePosition& cp) :
+        pos{ cp },
+        name{ std::move(name) },
+        arguments(std::move(arguments))
+    {
+    }
+};
+
+
 struct qlow::ast::Class : public AstObject
 {
     std::string name;
@@ -148,6 +181,9 @@ struct qlow::ast::Class : public AstObject
 
     /// true if it is a class, false if struct
     bool isReferenceType;
+
+    /// annotations preceding the definition, in source order
+    OwningList<Annotation> annotations;
     
     inline Class(std::string name, OwningList<FeatureDeclaration>& features, bool isReferenceType, const CodePosition& cp) :
         AstObject{ cp },
@@ -197,15 +233,18 @@ struct qlow::ast::ClassType : public ast::Type
 struct qlow::ast::ArrayType : public ast::Type 
 {
     std::unique_ptr<ast::Type> arrayType;
+    /// set by <code>@soa</code> after the brackets
+    bool soa;
     
-    inline ArrayType(std::unique_ptr<ast::Type> arrayType, const CodePosition& cp) :
+    inline ArrayType(std::unique_ptr<ast::Type> arrayType, const CodePosition& cp, bool soa = false) :
         Type{ cp },
-        arrayType{ std::move(arrayType) }
+        arrayType{ std::move(arrayType) },
+        soa{ soa }
     {
     }
     
     inline std::string asString(void) const override {
-        return std::string("[") + arrayType->asString() + "]";
+        return std::string("[") + arrayType->asString() + "]" + (soa ? " @soa" : "");
     }
 };
 
@@ -261,6 +300,9 @@ struct qlow::ast::MethodDefinition : public FeatureDeclaration
     /// been declared and not defined (with extern)
     std::unique_ptr<DoEndBlock> body;
 
+    /// annotations preceding the definition, in source order
+    OwningList<Annotation> annotations;
+
     inline MethodDefinition(std::unique_ptr<ast::Type> type, const std::string& name,
             std::unique_ptr<DoEndBlock> body, const CodePosition& cp) :
         FeatureDeclaration{ std::move(type), name, cp },
@@ -394,6 +436,120 @@ struct qlow::ast::WhileBlock : public Statement
 };
 
 
+/*!
+ * \brief <code>for i in a..b do</code> or <code>for x in array do</code>
+ *
+ * Ranges include the start but not the end. Exactly one of \ref array and
+ * \ref from and \ref to is set.
+ */
+struct qlow::ast::ForBlock : public Statement
+{
+    std::string variable;
+    CodePosition variablePos;
+    std::unique_ptr<Expression> from;
+    std::unique_ptr<Expression> to;
+    std::unique_ptr<Expression> array;
+    std::unique_ptr<DoEndBlock> body;
+
+    inline ForBlock(std::string variable, const CodePosition& variablePos,
+                    std::unique_ptr<Expression> from,
+                    std::unique_ptr<Expression> to,
+                    std::unique_ptr<DoEndBlock> body,
+                    const CodePosition& cp) :
+        AstObject{ cp },
+        Statement{ cp },
+        variable{ std::move(variable) },
+        variablePos{ variablePos },
+        from{ std::move(from) },
+        to{ std::move(to) },
+        body{ std::move(body) }
+    {
+    }
+
+    inline ForBlock(std::string variable, const CodePosition& variablePos,
+                    std::unique_ptr<Expression> array,
+                    std::unique_ptr<DoEndBlock> body,
+                    const CodePosition& cp) :
+        AstObject{ cp },
+        Statement{ cp },
+        variable{ std::move(variable) },
+        variablePos{ variablePos },
+        array{ std::move(array) },
+        body{ std::move(body) }
+    {
+    }
+
+    virtual std::unique_ptr<sem::SemanticObject> accept(StructureVisitor& v, sem::Scope&);
+};
+
+
+struct qlow::ast::MatchCase
+{
+    OwningList<Expression> values;
+    std::unique_ptr<DoEndBlock> body;
+    CodePosition pos;
+
+    inline MatchCase(OwningList<Expression>&& values, std::unique_ptr<DoEndBlock> body,
+                     const CodePosition& pos) :
+        values{ std::move(values) },
+        body{ std::move(body) },
+        pos{ pos }
+    {
+    }
+};
+
+
+/*!
+ * \brief <code>match x do case 1, 2 do ... end else ... end</code>
+ *
+ * The else branch is either a block or <code>else unreachable</code>.
+ */
+struct qlow::ast::MatchBlock : public Statement
+{
+    std::unique_ptr<Expression> value;
+    OwningList<MatchCase> cases;
+    std::unique_ptr<DoEndBlock> elseBlock;
+    bool elseUnreachable;
+
+    inline MatchBlock(std::unique_ptr<Expression> value,
+                      OwningList<MatchCase>&& cases,
+                      std::unique_ptr<DoEndBlock> elseBlock,
+                      bool elseUnreachable,
+                      const CodePosition& cp) :
+        AstObject{ cp },
+        Statement{ cp },
+        value{ std::move(value) },
+        cases{ std::move(cases) },
+        elseBlock{ std::move(elseBlock) },
+        elseUnreachable{ elseUnreachable }
+    {
+    }
+
+    virtual std::unique_ptr<sem::SemanticObject> accept(StructureVisitor& v, sem::Scope&);
+};
+
+
+/*!
+ * \brief <code>region do ... end</code>
+ *
+ * Objects allocated while the block executes are freed together when it
+ * is left.
+ */
+struct qlow::ast::RegionBlock : public Statement
+{
+    std::unique_ptr<DoEndBlock> body;
+
+    inline RegionBlock(std::unique_ptr<DoEndBlock> body, const CodePosition& cp) :
+        AstObject{ cp },
+        Statement{ cp },
+        body{ std::move(body) }
+    {
+    }
+
+    virtual std::unique_ptr<sem::SemanticObject> accept(StructureVisitor& v, sem::Scope&);
+};
+
+
 struct qlow::ast::Expression : public virtual AstObject
 {
     inline Expression(const CodePosition& cp) :
@@ -460,15 +616,35 @@ struct qlow::ast::AssignmentStatement : public Statement
 };
 
 
+/// <code>delete x</code>
+struct qlow::ast::DeleteStatement : public Statement
+{
+    std::unique_ptr<Expression> expr;
+
+    inline DeleteStatement(std::unique_ptr<Expression> expr, const CodePosition& cp) :
+        AstObject{ cp },
+        Statement{ cp },
+        expr{ std::move(expr) }
+    {
+    }
+
+    virtual std::unique_ptr<sem::SemanticObject> accept(StructureVisitor& v, sem::Scope&);
+};
+
+
 struct qlow::ast::LocalVariableStatement : public Statement
 {
     std::string name;
     std::unique_ptr<ast::Type> type;
-    inline LocalVariableStatement(std::string&& name, std::unique_ptr<Type> type, const CodePosition& cp) :
+    /// declared as <code>x: owned T</code>
+    bool owned;
+    inline LocalVariableStatement(std::string&& name, std::unique_ptr<Type> type, const CodePosition& cp,
+                                  bool owned = false) :
         AstObject{ cp },
         Statement{ cp },
        name{ name },
-       type{ std::move(type) }
+       type{ std::move(type) },
+       owned{ owned }
     {
     } 
 
@@ -523,6 +699,15 @@ struct qlow::ast::IntConst : public Expression
 };
 
 
+struct qlow::ast::FloatConst : public Expression
+{
+    double value;
+
+    FloatConst(const std::string& val, const CodePosition& p);
+    virtual std::unique_ptr<sem::SemanticObject> accept(StructureVisitor& v, sem::Scope&);
+};
+
+
 struct qlow::ast::StringConst : public Expression
 {
     std::string value;
@@ -4,6 +4,7 @@
 #include "Context.h"
 
 #include <typeinfo>
+#include <set>
 
 #include "Util.h"
 
@@ -30,6 +31,7 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::FieldDeclarati
 {
     auto f = std::make_unique<sem::Field>(scope.getContext());
     f->name = ast.name;
+    f->pos = ast.pos;
     auto* type = scope.getType(ast.type.get());
     if (type != nullptr) {
         f->type = type;
@@ -56,6 +58,7 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::MethodDefiniti
     auto m = std::make_unique<sem::Method>(scope, returnType, ast.isExtern());
     m->name = ast.name;
     m->astNode = &ast;
+    applyAnnotations(*m, ast);
     
     for (auto& arg : ast.arguments) {
         auto var = arg->accept(*this, scope);
@@ -81,6 +84,7 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::VariableDeclar
 {
     auto v = std::make_unique<sem::Variable>(scope.getContext());
     v->name = ast.name;
+    v->pos = ast.pos;
     auto type = scope.getType(ast.type.get());
     if (type != nullptr) {
         v->type = type;
@@ -103,6 +107,13 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::Statement& ast
 }
 
 
+/// true for the types of heap objects, which can be deleted and owned
+static bool isHeapType(const sem::Type* type)
+{
+    return type->isReferenceType() || type->isArrayType();
+}
+
+
 std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::DoEndBlock& ast, sem::Scope& scope)
 {
     sem::LocalScope* lscope = dynamic_cast<sem::LocalScope*>(&scope);
@@ -118,7 +129,13 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::DoEndBlock& as
                 throw SemanticError(SemanticError::UNKNOWN_TYPE,
                                     nvs->type->asString(),
                                     nvs->type->pos);
+            if (nvs->owned && !isHeapType(type))
+                throw SemanticError(SemanticError::TYPE_MISMATCH,
+                                    "'" + type->asString() + "' values cannot be owned",
+                                    nvs->type->pos);
             auto var = std::make_unique<sem::Variable>(scope.getContext(), type, nvs->name);
+            var->pos = nvs->pos;
+            var->isOwned = nvs->owned;
             body->scope.putVariable(nvs->name, std::move(var));
             continue;
         }
@@ -132,6 +149,7 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::DoEndBlock& as
         else {
             body->statements.push_back(unique_dynamic_cast<sem::Statement>(std::move(v)));
         }
+        body->statements.back()->pos = statement->pos;
     }
     return body;
 }
@@ -176,6 +194,133 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::WhileBlock& as
 }
 
 
+/// returns the number of bits of \p type if it is an integer type, 0 otherwise
+static unsigned getIntegerWidth(const sem::Type* type)
+{
+    auto* native = dynamic_cast<const sem::NativeType*>(type);
+    return native != nullptr ? native->getIntegerWidth() : 0;
+}
+
+
+std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::ForBlock& ast, sem::Scope& scope)
+{
+    sem::LocalScope* lscope = dynamic_cast<sem::LocalScope*>(&scope);
+    if (!lscope)
+        throw "error: non-method scope inside method";
+    auto fb = std::make_unique<sem::ForBlock>(*lscope);
+
+    sem::Type* variableType;
+    if (ast.array) {
+        fb->array = unique_dynamic_cast<sem::Expression>(ast.array->accept(*this, scope));
+        if (!fb->array->type->isArrayType())
+            throw SemanticError(SemanticError::TYPE_MISMATCH,
+                "cannot iterate over '" + fb->array->type->asString() + "'",
+                ast.array->pos);
+        variableType = fb->array->type->getArrayOf();
+    }
+    else {
+        fb->from = unique_dynamic_cast<sem::Expression>(ast.from->accept(*this, scope));
+        fb->to = unique_dynamic_cast<sem::Expression>(ast.to->accept(*this, scope));
+        variableType = fb->from->type;
+
+        if (getIntegerWidth(variableType) == 0)
+            throw SemanticError(SemanticError::TYPE_MISMATCH,
+                "range bounds must be integers, not '" + variableType->asString() + "'",
+                ast.from->pos);
+        if (!fb->to->type->equals(*variableType))
+            throw SemanticError(SemanticError::TYPE_MISMATCH,
+                "range from '" + variableType->asString() + "' to '" +
+                fb->to->type->asString() + "'",
+                ast.to->pos);
+    }
+
+    auto var = std::make_unique<sem::Variable>(scope.getContext(), variableType, ast.variable);
+    var->pos = ast.variablePos;
+    fb->variable = var.get();
+    fb->scope.putVariable(ast.variable, std::move(var));
+
+    fb->body = unique_dynamic_cast<sem::DoEndBlock>(ast.body->accept(*this, fb->scope));
+    return fb;
+}
+
+
+/*!
+ * \brief evaluates a case label, an integer literal with an optional minus
+ *        sign, to its bit pattern in \p type
+ */
+static unsigned long long evaluateCaseValue(const ast::Expression& expr, const sem::Type* type)
+{
+    bool negative = false;
+    const ast::Expression* literal = &expr;
+    if (auto* unop = dynamic_cast<const ast::UnaryOperation*>(&expr);
+        unop != nullptr && unop->side == ast::UnaryOperation::PREFIX && unop->opString == "-") {
+        negative = true;
+        literal = unop->expr.get();
+    }
+
+    auto* constant = dynamic_cast<const ast::IntConst*>(literal);
+    if (constant == nullptr)
+        throw SemanticError(SemanticError::TYPE_MISMATCH,
+            "case values must be integer literals", expr.pos);
+
+    const unsigned width = getIntegerWidth(type);
+    const bool isUnsigned = static_cast<const sem::NativeType*>(type)->isUnsignedType();
+    const unsigned long long mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    unsigned long long limit = isUnsigned ? mask : mask >> 1;
+    if (negative && !isUnsigned)
+        limit++;
+    if ((negative && isUnsigned) || constant->value > limit)
+        throw SemanticError(SemanticError::TYPE_MISMATCH,
+            "case value out of range for '" + type->asString() + "'", expr.pos);
+
+    return (negative ? 0 - constant->value : constant->value) & mask;
+}
+
+
+std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::MatchBlock& ast, sem::Scope& scope)
+{
+    auto value = unique_dynamic_cast<sem::Expression>(ast.value->accept(*this, scope));
+    sem::Type* type = value->type;
+    const unsigned width = getIntegerWidth(type);
+    if (width == 0)
+        throw SemanticError(SemanticError::TYPE_MISMATCH,
+            "cannot match on '" + type->asString() + "'", ast.value->pos);
+
+    auto mb = std::make_unique<sem::MatchBlock>(scope.getContext());
+    mb->value = std::move(value);
+    std::set<unsigned long long> handled;
+    for (auto& matchCase : ast.cases) {
+        sem::MatchBlock::Case c;
+        for (auto& label : matchCase->values) {
+            unsigned long long v = evaluateCaseValue(*label, type);
+            if (!handled.insert(v).second)
+                throw SemanticError(SemanticError::DUPLICATE_CASE,
+                    "value is already handled by another case", label->pos);
+            c.values.push_back(v);
+        }
+        c.body = unique_dynamic_cast<sem::DoEndBlock>(matchCase->body->accept(*this, scope));
+        mb->cases.push_back(std::move(c));
+    }
+
+    bool exhaustive = width < 64 && handled.size() == (1ULL << width);
+    if (ast.elseBlock) {
+        mb->elseBlock = unique_dynamic_cast<sem::DoEndBlock>(ast.elseBlock->accept(*this, scope));
+    }
+    else if (!exhaustive && !ast.elseUnreachable) {
+        throw SemanticError(SemanticError::NON_EXHAUSTIVE_MATCH,
+            "add an 'else' branch or 'else unreachable'", ast.pos);
+    }
+    return mb;
+}
+
+
+std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::RegionBlock& ast, sem::Scope& scope)
+{
+    auto body = unique_dynamic_cast<sem::DoEndBlock>(ast.body->accept(*this, scope));
+    return std::make_unique<sem::RegionBlock>(std::move(body));
+}
+
+
 std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::Expression& ast, sem::Scope& scope)
 {
     throw "visit(Expression) shouldn't be called";
@@ -284,6 +429,17 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::FeatureCall& a
 }
 
 
+/// a new array takes the layout of the array it is assigned to, so that
+/// <code>new [T; n]</code> can initialize <code>[T] @soa</code> arrays
+static void adoptArrayLayout(sem::Expression& value, sem::Type* targetType)
+{
+    auto* newArray = dynamic_cast<sem::NewArrayExpression*>(&value);
+    if (newArray != nullptr && targetType->isArrayType() &&
+        targetType->getArrayOf() == newArray->elementType)
+        newArray->type = targetType;
+}
+
+
 std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::AssignmentStatement& ast, sem::Scope& scope)
 {
     auto as = std::make_unique<sem::AssignmentStatement>(scope.getContext());
@@ -292,6 +448,7 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::AssignmentStat
 //    as->target = unique_dynamic_cast<sem::Expression>(visit(*ast.target, classes));
     as->value = unique_dynamic_cast<sem::Expression>(ast.expr->accept(*this, scope));
     as->target = unique_dynamic_cast<sem::Expression>(ast.target->accept(*this, scope));
+    adoptArrayLayout(*as->value, as->target->type);
 
     if (as->target->type->operator==(*as->value->type)) {
         return as;
@@ -343,6 +500,19 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::ReturnStatemen
 }
 
 
+std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::DeleteStatement& ast, sem::Scope& scope)
+{
+    auto value = unique_dynamic_cast<sem::Expression>(ast.expr->accept(*this, scope));
+    if (!isHeapType(value->type))
+        throw SemanticError(SemanticError::TYPE_MISMATCH,
+            "cannot delete a value of type '" + value->type->asString() + "'", ast.expr->pos);
+
+    auto ds = std::make_unique<sem::DeleteStatement>(scope.getContext());
+    ds->value = std::move(value);
+    return ds;
+}
+
+
 std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::LocalVariableStatement& ast, sem::Scope& scope)
 {
     throw "shouldn't be called";
@@ -368,6 +538,9 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(
 {
     auto array = unique_dynamic_cast<sem::Expression>(ast.array->accept(*this, scope));
     auto index = unique_dynamic_cast<sem::Expression>(ast.index->accept(*this, scope));
+    if (getIntegerWidth(index->type) == 0)
+        throw SemanticError(SemanticError::TYPE_MISMATCH,
+            "array index must be an integer, not " + index->type->asString(), ast.index->pos);
 
     return std::make_unique<sem::ArrayAccessExpression>(std::move(array), std::move(index), ast.pos);
 }
@@ -379,6 +552,12 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::IntConst& ast,
 }
 
 
+std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::FloatConst& ast, sem::Scope& scope)
+{
+    return std::make_unique<sem::FloatConst>(scope.getContext(), ast.value, ast.pos);
+}
+
+
 std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::StringConst& ast, sem::Scope& scope)
 {
     // TODO implement
@@ -425,7 +604,7 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::BinaryOperatio
             ast.opPos);
     }
     
-    auto ret = std::make_unique<sem::BinaryOperation>(context, leftEval->type, &ast);
+    auto ret = std::make_unique<sem::BinaryOperation>(context, operationMethod->returnType, &ast);
     
     ret->operationMethod = operationMethod;
     ret->opString = ast.opString;
@@ -451,6 +630,9 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::NewExpression&
 std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::NewArrayExpression& ast, sem::Scope& scope)
 {
     auto length = unique_dynamic_cast<sem::Expression>(ast.length->accept(*this, scope));
+    if (getIntegerWidth(length->type) == 0)
+        throw SemanticError(SemanticError::TYPE_MISMATCH,
+            "array length must be an integer, not " + length->type->asString(), ast.length->pos);
     auto ret = std::make_unique<sem::NewArrayExpression>(scope.getType(ast.type.get()), std::move(length), ast.pos);
     return ret;
 }
@@ -460,6 +642,33 @@ std::unique_ptr<sem::SemanticObject> StructureVisitor::visit(ast::CastExpression
 {
     auto expr = unique_dynamic_cast<sem::Expression>(ast.expression->accept(*this, scope));
     auto type = scope.getType(ast.targetType.get());
+
+    auto isScalar = [&scope] (sem::Type* t) {
+        return t != nullptr && t->isNativeType() &&
+            !static_cast<sem::NativeType*>(t)->isVectorType() &&
+            t != scope.getContext().getNativeType(sem::NativeType::NType::VOID);
+    };
+
+    // casting an Integer or a Float to a vector type fills all lanes with it
+    if (type != nullptr && type->isNativeType() &&
+        static_cast<sem::NativeType*>(type)->isVectorType()) {
+        auto* from = expr->type;
+        if (from != scope.getContext().getNativeType(sem::NativeType::NType::INTEGER) &&
+            !(from->isNativeType() && static_cast<sem::NativeType*>(from)->isFloatingPointType())) {
+            throw SemanticError(SemanticError::TYPE_MISMATCH,
+                "cannot cast from '" + expr->type->asString() + "' to '" + type->asString() + "'",
+                ast.pos);
+        }
+        return std::make_unique<sem::CastExpression>(
+            std::move(expr), type, &ast, true, ast.pos);
+    }
+
+    // conversions between scalar native types, e.g. Integer to Float64
+    if (isScalar(type) && isScalar(expr->type)) {
+        return std::make_unique<sem::CastExpression>(
+            std::move(expr), type, &ast, true, ast.pos);
+    }
+
     return std::make_unique<sem::CastExpression>(
         std::move(expr), type, &ast, false, ast.pos);
 }
@@ -471,6 +680,7 @@ std::unique_ptr<sem::Expression> StructureVisitor::createImplicitCast(
 #ifdef DEBUGGING
     Printer::getInstance() << "casting " << expr->type->asString() << " to " << targetType->asString() << std::endl;
 #endif
+    adoptArrayLayout(*expr, targetType);
     if (expr->type->equals(*targetType))
         return expr;
     auto* exprType = expr->type;
@@ -487,5 +697,95 @@ std::unique_ptr<sem::Expression> StructureVisitor::createImplicitCast(
 }
 
 
+void StructureVisitor::applyAnnotations(sem::Method& method, const ast::MethodDefinition& ast)
+{
+    using Inlining = sem::Method::Inlining;
+    using Hotness = sem::Method::Hotness;
+    static const std::map<std::string, Inlining> inliningAnnotations = {
+        { "inline",         Inlining::INLINE },
+        { "noinline",       Inlining::NO_INLINE },
+        { "always_inline",  Inlining::ALWAYS_INLINE },
+    };
+    static const std::map<std::string, Hotness> hotnessAnnotations = {
+        { "hot",            Hotness::HOT },
+        { "cold",           Hotness::COLD },
+    };
+
+    for (auto& annotation : ast.annotations) {
+        if (!annotation->arguments.empty() &&
+                (inliningAnnotations.count(annotation->name) ||
+                 hotnessAnnotations.count(annotation->name)))
+            throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                "'@" + annotation->name + "' takes no arguments",
+                annotation->pos);
+
+        if (auto inl = inliningAnnotations.find(annotation->name); inl != inliningAnnotations.end()) {
+            if (method.inlining != Inlining::DEFAULT)
+                throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                    "conflicting inlining annotation '@" + annotation->name + "'",
+                    annotation->pos);
+            method.inlining = inl->second;
+        }
+        else if (annotation->name == "tailcall") {
+            if (!annotation->arguments.empty())
+                throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                    "'@tailcall' takes no arguments",
+                    annotation->pos);
+            method.guaranteedTailCalls = true;
+        }
+        else if (annotation->name == "target_clones") {
+            if (annotation->arguments.empty() || !method.targetClones.empty())
+                throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                    "'@target_clones' needs a list of cpu features",
+                    annotation->pos);
+            method.targetClones = annotation->arguments;
+        }
+        else if (auto hot = hotnessAnnotations.find(annotation->name); hot != hotnessAnnotations.end()) {
+            if (method.hotness != Hotness::DEFAULT)
+                throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                    "conflicting annotation '@" + annotation->name + "'",
+                    annotation->pos);
+            method.hotness = hot->second;
+        }
+        else {
+            throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                "unknown annotation '@" + annotation->name + "'",
+                annotation->pos);
+        }
+    }
+}
+
+
+void StructureVisitor::applyAnnotations(sem::Class& semClass, const ast::Class& ast)
+{
+    for (auto& annotation : ast.annotations) {
+        if (annotation->name == "packed") {
+            if (!annotation->arguments.empty())
+                throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                    "'@packed' takes no arguments",
+                    annotation->pos);
+            semClass.packed = true;
+        }
+        else if (annotation->name == "align") {
+            // the alignment must be a power of two that llvm can handle
+            unsigned long alignment = 0;
+            if (annotation->arguments.size() == 1 && !annotation->arguments[0].empty() &&
+                    annotation->arguments[0].find_first_not_of("0123456789") == std::string::npos &&
+                    annotation->arguments[0].size() <= 5)
+                alignment = std::stoul(annotation->arguments[0]);
+            if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment > 4096 ||
+                    semClass.alignment != 0)
+                throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                    "'@align' needs a power of two up to 4096",
+                    annotation->pos);
+            semClass.alignment = static_cast<unsigned>(alignment);
+        }
+        else {
+            throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                "unknown annotation '@" + annotation->name + "'",
+                annotation->pos);
+        }
+    }
+}
 
 
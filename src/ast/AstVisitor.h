@@ -42,14 +42,19 @@ class qlow::StructureVisitor :
         ast::DoEndBlock,
         ast::IfElseBlock,
         ast::WhileBlock,
+        ast::ForBlock,
+        ast::MatchBlock,
+        ast::RegionBlock,
         ast::Expression,
         ast::FeatureCall,
         ast::AssignmentStatement,
         ast::ReturnStatement,
+        ast::DeleteStatement,
         ast::LocalVariableStatement,
         ast::AddressExpression,
         ast::ArrayAccessExpression,
         ast::IntConst,
+        ast::FloatConst,
         ast::StringConst,
         ast::UnaryOperation,
         ast::BinaryOperation,
@@ -70,14 +75,19 @@ public:
     ReturnType visit(ast::DoEndBlock& ast, sem::Scope& scope) override;
     ReturnType visit(ast::IfElseBlock& ast, sem::Scope& scope) override;
     ReturnType visit(ast::WhileBlock& ast, sem::Scope& scope) override;
+    ReturnType visit(ast::ForBlock& ast, sem::Scope& scope) override;
+    ReturnType visit(ast::MatchBlock& ast, sem::Scope& scope) override;
+    ReturnType visit(ast::RegionBlock& ast, sem::Scope& scope) override;
     ReturnType visit(ast::Expression& ast, sem::Scope& scope) override;
     ReturnType visit(ast::FeatureCall& ast, sem::Scope& scope) override;
     ReturnType visit(ast::AssignmentStatement& ast, sem::Scope& scope) override;
     ReturnType visit(ast::ReturnStatement& ast, sem::Scope& scope) override;
+    ReturnType visit(ast::DeleteStatement& ast, sem::Scope& scope) override;
     ReturnType visit(ast::LocalVariableStatement& ast, sem::Scope& scope) override;
     ReturnType visit(ast::AddressExpression& ast, sem::Scope& scope) override;
     ReturnType visit(ast::ArrayAccessExpression& ast, sem::Scope& scope) override;
     ReturnType visit(ast::IntConst& ast, sem::Scope& scope) override;
+    ReturnType visit(ast::FloatConst& ast, sem::Scope& scope) override;
     ReturnType visit(ast::StringConst& ast, sem::Scope& scope) override;
     ReturnType visit(ast::UnaryOperation& ast, sem::Scope& scope) override;
     ReturnType visit(ast::BinaryOperation& ast, sem::Scope& scope) override;
@@ -86,6 +96,23 @@ public:
     ReturnType visit(ast::CastExpression& ast, sem::Scope& scope) override;
 
     std::unique_ptr<sem::Expression> createImplicitCast(std::unique_ptr<sem::Expression>, sem::Type* targetType, sem::Scope& scope);
+
+    /*!
+     * \brief translates the annotations of a method definition into
+     *        attributes of the semantic method
+     *
+     * \throws SemanticError if an annotation is unknown or conflicts
+     *         with another one
+     */
+    void applyAnnotations(sem::Method& method, const ast::MethodDefinition& ast);
+
+    /*!
+     * \brief translates the layout annotations <code>@packed</code> and
+     *        <code>@align(N)</code> of a class definition
+     *
+     * \throws SemanticError if an annotation is unknown or invalid
+     */
+    void applyAnnotations(sem::Class& semClass, const ast::Class& ast);
 };
 
 
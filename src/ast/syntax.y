@@ -130,6 +130,11 @@ while (0)
     qlow::ast::DoEndBlock* doEndBlock;    
     qlow::ast::IfElseBlock* ifElseBlock;    
     qlow::ast::WhileBlock* whileBlock;    
+    qlow::ast::ForBlock* forBlock;
+    qlow::ast::MatchBlock* matchBlock;
+    qlow::ast::RegionBlock* regionBlock;
+    qlow::ast::MatchCase* matchCase;
+    std::vector<std::unique_ptr<qlow::ast::MatchCase>>* matchCases;
     qlow::ast::Statement* statement;
     qlow::ast::Expression* expression;
 
@@ -139,6 +144,7 @@ while (0)
     qlow::ast::FeatureCall* featureCall;
     qlow::ast::AssignmentStatement* assignmentStatement;
     qlow::ast::ReturnStatement* returnStatement;
+    qlow::ast::DeleteStatement* deleteStatement;
     qlow::ast::LocalVariableStatement* localVariableStatement;
     qlow::ast::AddressExpression* addressExpression;
     qlow::ast::ArrayAccessExpression* arrayAccessExpression;
@@ -153,6 +159,9 @@ while (0)
     qlow::ast::ImportDeclaration* importDeclaration;
     std::vector<std::unique_ptr<qlow::ast::ImportDeclaration>>* importList;
 
+    qlow::ast::Annotation* annotation;
+    std::vector<std::string>* stringList;
+
     const char* cString;
     std::string* string;
     int token;
@@ -161,12 +170,17 @@ while (0)
 
 %token <string> IDENTIFIER
 %token <string> INT_LITERAL
+%token <string> FLOAT_LITERAL
+%token <string> STRING_LITERAL
+%token <string> ANNOTATION
 %token <string> ASTERISK SLASH PLUS MINUS EQUALS NOT_EQUALS AND OR XOR CUSTOM_OPERATOR
+%token <string> PERCENT AMPERSAND PIPE CARET SHIFT_LEFT SHIFT_RIGHT
+%token <string> LESS LESS_EQUALS GREATER GREATER_EQUALS
 %token <token> TRUE FALSE
-%token <token> CLASS STRUCT DO END IF ELSE WHILE RETURN NEW AS
+%token <token> CLASS STRUCT DO END IF ELSE WHILE FOR IN MATCH CASE UNREACHABLE REGION RETURN NEW DELETE OWNED SOA AS
 %token <token> EXTERN IMPORT
 %token <token> NEW_LINE
-%token <token> SEMICOLON COLON COMMA DOT ASSIGN AMPERSAND
+%token <token> SEMICOLON COLON COMMA DOT DOUBLE_DOT ASSIGN
 %token <token> ROUND_LEFT ROUND_RIGHT SQUARE_LEFT SQUARE_RIGHT
 %token <string> UNEXPECTED_SYMBOL
 
@@ -187,11 +201,17 @@ while (0)
 %type <doEndBlock> doEndBlock
 %type <ifElseBlock> ifElseBlock
 %type <whileBlock> whileBlock
+%type <forBlock> forBlock
+%type <matchBlock> matchBlock
+%type <matchCase> matchCase
+%type <matchCases> matchCases
+%type <regionBlock> regionBlock
 %type <statement> statement
 %type <expression> expression operationExpression paranthesesExpression
 %type <featureCall> featureCall
 %type <assignmentStatement> assignmentStatement
 %type <returnStatement> returnStatement
+%type <deleteStatement> deleteStatement
 %type <localVariableStatement> localVariableStatement
 %type <addressExpression> addressExpression
 %type <arrayAccessExpression> arrayAccessExpression
@@ -201,6 +221,9 @@ while (0)
 %type <newExpression> newExpression
 %type <newArrayExpression> newArrayExpression
 %type <castExpression> castExpression
+%type <annotation> annotation
+%type <stringList> annotationArguments
+%type <string> annotationArgument
 
 %destructor { } <token>
 //%destructor { if ($$) delete $$ } <op>
@@ -212,15 +235,19 @@ while (0)
 %left OR XOR
 %left AND
 %left NOT
-%left EQUALS
+%left EQUALS NOT_EQUALS LESS LESS_EQUALS GREATER GREATER_EQUALS
+%left PIPE
+%left CARET
+%left AMPERSAND
+%left SHIFT_LEFT SHIFT_RIGHT
 %left PLUS MINUS
-%left ASTERISK SLASH
+%left ASTERISK SLASH PERCENT
 %left AS
 %left DOT
 
 %start topLevel
 
-%expect 77
+%expect 45
 
 %%
 
@@ -300,6 +327,15 @@ classDefinition:
         delete $2; delete $3; $2 = 0; $3 = 0;
     }
     |
+    annotation classDefinition {
+        $$ = $2;
+        if ($$ != nullptr)
+            $$->annotations.emplace($$->annotations.begin(), $1);
+        else
+            delete $1;
+        $1 = nullptr;
+    }
+    |
     CLASS error END {
         reportError(qlow::SyntaxError(@2));
         yyerrok;
@@ -329,6 +365,11 @@ type:
         $2 = nullptr;
     }
     |
+    SQUARE_LEFT type SQUARE_RIGHT SOA {
+        $$ = new qlow::ast::ArrayType(std::unique_ptr<qlow::ast::Type>($2), @$, true);
+        $2 = nullptr;
+    }
+    |
     SQUARE_LEFT error SQUARE_RIGHT {
         reportError(qlow::SyntaxError("invalid type", @2));
     };
@@ -417,6 +458,52 @@ methodDefinition:
     IDENTIFIER ROUND_LEFT argumentList ROUND_RIGHT doEndBlock {
         $$ = new MethodDefinition(nullptr, *$1, std::move(*$3), std::unique_ptr<DoEndBlock>($5), @$);
         delete $1; delete $3; $1 = nullptr; $3 = nullptr;
+    }
+    |
+    annotation methodDefinition {
+        $$ = $2;
+        $$->annotations.emplace($$->annotations.begin(), $1);
+        $1 = nullptr;
+    };
+
+
+annotation:
+    ANNOTATION {
+        $$ = new qlow::ast::Annotation(std::move(*$1), @$);
+        delete $1; $1 = nullptr;
+    }
+    |
+    ANNOTATION ROUND_LEFT annotationArguments ROUND_RIGHT {
+        $$ = new qlow::ast::Annotation(std::move(*$1), std::move(*$3), @$);
+        delete $1; delete $3; $1 = nullptr; $3 = nullptr;
+    };
+
+
+annotationArguments:
+    annotationArgument {
+        $$ = new std::vector<std::string>();
+        $$->push_back(std::move(*$1));
+        delete $1; $1 = nullptr;
+    }
+    |
+    annotationArguments COMMA annotationArgument {
+        $$ = $1;
+        $$->push_back(std::move(*$3));
+        delete $3; $3 = nullptr;
+    };
+
+
+annotationArgument:
+    IDENTIFIER {
+        $$ = $1;
+    }
+    |
+    INT_LITERAL {
+        $$ = $1;
+    }
+    |
+    STRING_LITERAL {
+        $$ = $1;
     };
 
 
@@ -471,6 +558,65 @@ whileBlock:
     };
 
 
+forBlock:
+    FOR IDENTIFIER IN expression DOUBLE_DOT expression doEndBlock {
+        $$ = new ForBlock(std::move(*$2), @2, std::unique_ptr<Expression>($4),
+                          std::unique_ptr<Expression>($6), std::unique_ptr<DoEndBlock>($7), @$);
+        delete $2; $2 = nullptr; $4 = nullptr; $6 = nullptr; $7 = nullptr;
+    }
+    |
+    FOR IDENTIFIER IN expression doEndBlock {
+        $$ = new ForBlock(std::move(*$2), @2, std::unique_ptr<Expression>($4),
+                          std::unique_ptr<DoEndBlock>($5), @$);
+        delete $2; $2 = nullptr; $4 = nullptr; $5 = nullptr;
+    };
+
+
+matchBlock:
+    MATCH expression DO pnl matchCases END {
+        $$ = new MatchBlock(std::unique_ptr<Expression>($2), std::move(*$5),
+                            nullptr, false, @$);
+        $2 = nullptr; delete $5; $5 = nullptr;
+    }
+    |
+    MATCH expression DO pnl matchCases ELSE doEndBlock statementEnd END {
+        $$ = new MatchBlock(std::unique_ptr<Expression>($2), std::move(*$5),
+                            std::unique_ptr<DoEndBlock>($7), false, @$);
+        $2 = nullptr; delete $5; $5 = nullptr; $7 = nullptr;
+    }
+    |
+    MATCH expression DO pnl matchCases ELSE UNREACHABLE statementEnd END {
+        $$ = new MatchBlock(std::unique_ptr<Expression>($2), std::move(*$5),
+                            nullptr, true, @$);
+        $2 = nullptr; delete $5; $5 = nullptr;
+    };
+
+
+matchCases:
+    /* empty */ {
+        $$ = new std::vector<std::unique_ptr<MatchCase>>();
+    }
+    |
+    matchCases matchCase {
+        $$ = $1;
+        $$->push_back(std::unique_ptr<MatchCase>($2));
+    };
+
+
+matchCase:
+    CASE expressionList doEndBlock statementEnd {
+        $$ = new MatchCase(std::move(*$2), std::unique_ptr<DoEndBlock>($3), @1);
+        delete $2; $2 = nullptr; $3 = nullptr;
+    };
+
+
+regionBlock:
+    REGION doEndBlock {
+        $$ = new RegionBlock(std::unique_ptr<DoEndBlock>($2), @$);
+        $2 = nullptr;
+    };
+
+
 statements:
     pnl {
         $$ = new std::vector<std::unique_ptr<Statement>>();
@@ -507,6 +653,10 @@ statement:
         $$ = $1;
     }
     |
+    deleteStatement statementEnd {
+        $$ = $1;
+    }
+    |
     localVariableStatement statementEnd {
         $$ = $1;
     }
@@ -519,6 +669,18 @@ statement:
         $$ = $1;
     }
     |
+    forBlock statementEnd {
+        $$ = $1;
+    }
+    |
+    matchBlock statementEnd {
+        $$ = $1;
+    }
+    |
+    regionBlock statementEnd {
+        $$ = $1;
+    }
+    |
     error statementEnd {
         $$ = nullptr;
         //printf("error happened here (%s): %d\n", qlow_parser_filename, @1.first_line);
@@ -607,6 +769,11 @@ expression:
     INT_LITERAL {
         $$ = new IntConst(*$1, @$);
         delete $1;
+    }
+    |
+    FLOAT_LITERAL {
+        $$ = new FloatConst(*$1, @$);
+        delete $1;
     };/*
     |
     error {
@@ -682,6 +849,66 @@ binaryOperation:
         delete $2; $2 = nullptr;
     }
     |
+    expression PERCENT expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression AMPERSAND expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression PIPE expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression CARET expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression SHIFT_LEFT expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression SHIFT_RIGHT expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression LESS expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression LESS_EQUALS expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression GREATER expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
+    expression GREATER_EQUALS expression {
+        $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
+            std::unique_ptr<Expression>($3), *$2, @$, @2);
+        delete $2; $2 = nullptr;
+    }
+    |
     expression CUSTOM_OPERATOR expression {
         $$ = new BinaryOperation(std::unique_ptr<Expression>($1), 
             std::unique_ptr<Expression>($3), *$2, @$, @2);
@@ -723,11 +950,30 @@ operator:
     |
     XOR { $$ = $1; }
     |
+    PERCENT { $$ = $1; }
+    |
+    PIPE { $$ = $1; }
+    |
+    CARET { $$ = $1; }
+    |
+    SHIFT_LEFT { $$ = $1; }
+    |
+    SHIFT_RIGHT { $$ = $1; }
+    |
+    LESS { $$ = $1; }
+    |
+    LESS_EQUALS { $$ = $1; }
+    |
+    GREATER { $$ = $1; }
+    |
+    GREATER_EQUALS { $$ = $1; }
+    |
     CUSTOM_OPERATOR { $$ = $1; };
 
 addressExpression:
     AMPERSAND expression {
         $$ = new AddressExpression(std::unique_ptr<Expression>($2), @$);
+        delete $1; $1 = nullptr;
         $2 = nullptr;
     };
 
@@ -777,10 +1023,21 @@ returnStatement:
         $$ = new ReturnStatement(nullptr, @$);
     };
 
+deleteStatement:
+    DELETE expression {
+        $$ = new DeleteStatement(std::unique_ptr<Expression>($2), @$);
+        $2 = nullptr;
+    };
+
 localVariableStatement:
     IDENTIFIER COLON type {
         $$ = new LocalVariableStatement(std::move(*$1), std::unique_ptr<qlow::ast::Type>($3), @$);
         delete $1; $3 = nullptr; $1 = nullptr;
+    }
+    |
+    IDENTIFIER COLON OWNED type {
+        $$ = new LocalVariableStatement(std::move(*$1), std::unique_ptr<qlow::ast::Type>($4), @$, true);
+        delete $1; $4 = nullptr; $1 = nullptr;
     };
 
 
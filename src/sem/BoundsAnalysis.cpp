@@ -0,0 +1,323 @@
+#include "BoundsAnalysis.h"
+#include "Semantic.h"
+#include "Builtin.h"
+#include "Traversal.h"
+
+#include <limits>
+
+using namespace qlow::sem;
+
+namespace
+{
+
+Variable* getLocalVariable(const Expression& expr)
+{
+    if (auto* lve = dynamic_cast<const LocalVariableExpression*>(&expr))
+        return lve->var;
+    return nullptr;
+}
+
+
+/// returns <code>a</code> if \p expr is <code>a.length</code> for a local array <code>a</code>
+Variable* getLengthOf(const Expression& expr)
+{
+    auto* call = dynamic_cast<const MethodCallExpression*>(&expr);
+    if (call == nullptr || call->target == nullptr ||
+        !call->target->type->isArrayType() ||
+        dynamic_cast<NativeMethod*>(call->callee) == nullptr ||
+        call->callee->name != "length")
+        return nullptr;
+    return getLocalVariable(*call->target);
+}
+
+
+bool isNonNegativeConstant(const Expression& expr, unsigned long long& value)
+{
+    if (auto* c = dynamic_cast<const IntConst*>(&expr)) {
+        value = c->value;
+        return value <= static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+    }
+    return false;
+}
+
+
+AssignmentStatement* asAssignmentTo(Statement& statement, Variable* var)
+{
+    auto* assignment = dynamic_cast<AssignmentStatement*>(&statement);
+    if (assignment != nullptr && getLocalVariable(*assignment->target) == var)
+        return assignment;
+    return nullptr;
+}
+
+
+bool assigns(Statement& statement, Variable* var)
+{
+    bool found = false;
+    forEachStatement(statement, [&] (Statement& s) {
+        if (asAssignmentTo(s, var))
+            found = true;
+    });
+    return found;
+}
+
+
+/// checks if \p assignment has the form <code>i := i + 1</code>
+bool isIncrement(AssignmentStatement& assignment, Variable* index)
+{
+    auto* binop = dynamic_cast<BinaryOperation*>(assignment.value.get());
+    if (binop == nullptr || binop->opString != "+" ||
+        dynamic_cast<NativeMethod*>(binop->operationMethod) == nullptr)
+        return false;
+
+    unsigned long long step = 0;
+    if (getLocalVariable(*binop->left) == index)
+        return isNonNegativeConstant(*binop->right, step) && step == 1;
+    if (getLocalVariable(*binop->right) == index)
+        return isNonNegativeConstant(*binop->left, step) && step == 1;
+    return false;
+}
+
+
+class LoopAnalysis
+{
+    Variable* index;
+    Variable* array;
+
+    /// set as soon as the index or the array may have changed
+    bool clobbered;
+public:
+    inline LoopAnalysis(Variable* index, Variable* array) :
+        index{ index }, array{ array }, clobbered{ false }
+    {
+    }
+
+    void markAccesses(Expression& expr)
+    {
+        forEachExpression(expr, [this] (Expression& e) {
+            auto* access = dynamic_cast<ArrayAccessExpression*>(&e);
+            if (access != nullptr &&
+                getLocalVariable(*access->array) == array &&
+                getLocalVariable(*access->index) == index)
+                access->needsBoundsCheck = false;
+        });
+    }
+
+
+    /// walks the statements in execution order until one of the
+    /// variables may have changed
+    void markAccesses(Statement& statement)
+    {
+        if (clobbered)
+            return;
+
+        if (auto* block = dynamic_cast<DoEndBlock*>(&statement)) {
+            for (auto& s : block->statements)
+                markAccesses(*s);
+        }
+        else if (auto* ifElse = dynamic_cast<IfElseBlock*>(&statement)) {
+            markAccesses(*ifElse->condition);
+            markAccesses(*ifElse->ifBlock);
+            bool clobberedInIf = clobbered;
+            clobbered = false;
+            if (ifElse->elseBlock)
+                markAccesses(*ifElse->elseBlock);
+            clobbered = clobbered || clobberedInIf;
+        }
+        else if (auto* match = dynamic_cast<MatchBlock*>(&statement)) {
+            markAccesses(*match->value);
+            // each case starts from the state before the match
+            bool clobberedInCase = false;
+            auto markCase = [&] (DoEndBlock& body) {
+                clobbered = false;
+                markAccesses(body);
+                clobberedInCase = clobberedInCase || clobbered;
+            };
+            for (auto& c : match->cases)
+                markCase(*c.body);
+            if (match->elseBlock)
+                markCase(*match->elseBlock);
+            clobbered = clobberedInCase;
+        }
+        else if (auto* region = dynamic_cast<RegionBlock*>(&statement)) {
+            markAccesses(*region->body);
+        }
+        else if (auto* loop = dynamic_cast<WhileBlock*>(&statement)) {
+            // an assignment in a later iteration would precede the
+            // accesses of the next one
+            if (assigns(*loop, index) || assigns(*loop, array)) {
+                clobbered = true;
+                return;
+            }
+            markAccesses(*loop->condition);
+            markAccesses(*loop->body);
+        }
+        else if (auto* loop = dynamic_cast<ForBlock*>(&statement)) {
+            forEachOwnExpression(*loop, [this] (Expression& e) { markAccesses(e); });
+            if (assigns(*loop->body, index) || assigns(*loop->body, array)) {
+                clobbered = true;
+                return;
+            }
+            markAccesses(*loop->body);
+        }
+        else {
+            forEachOwnExpression(statement, [this] (Expression& e) { markAccesses(e); });
+            if (asAssignmentTo(statement, index) || asAssignmentTo(statement, array))
+                clobbered = true;
+        }
+    }
+};
+
+
+/*!
+ * \brief tries to prove that <code>0 <= i < a.length</code> holds at the
+ *        start of every iteration of \p loop
+ *
+ * \param block the block containing the loop
+ * \param position the index of the loop in \p block
+ */
+void analyzeLoop(DoEndBlock& block, size_t position, WhileBlock& loop)
+{
+    auto* condition = dynamic_cast<BinaryOperation*>(loop.condition.get());
+    if (condition == nullptr ||
+        dynamic_cast<NativeMethod*>(condition->operationMethod) == nullptr)
+        return;
+
+    Expression* left = condition->left.get();
+    Expression* right = condition->right.get();
+    bool notEquals = false;
+    if (condition->opString == ">") {
+        std::swap(left, right);
+    }
+    else if (condition->opString == "!=") {
+        notEquals = true;
+        if (getLengthOf(*left))
+            std::swap(left, right);
+    }
+    else if (condition->opString != "<") {
+        return;
+    }
+
+    Variable* index = getLocalVariable(*left);
+    Variable* array = getLengthOf(*right);
+    if (index == nullptr || array == nullptr ||
+        index->type != loop.context.getNativeType(NativeType::NType::INTEGER))
+        return;
+
+    // the index must start at a non-negative constant
+    unsigned long long start = 0;
+    bool initialized = false;
+    for (size_t i = position; i-- > 0;) {
+        if (auto* assignment = asAssignmentTo(*block.statements[i], index)) {
+            initialized = isNonNegativeConstant(*assignment->value, start);
+            break;
+        }
+        if (assigns(*block.statements[i], index))
+            break;
+    }
+    if (!initialized)
+        return;
+
+    // ... and is incremented by one exactly once per iteration. It is
+    // below the length before the increment, so it cannot overflow. A
+    // larger step or a second increment could wrap around to a negative
+    // index, which passes the comparison again.
+    bool onlyIncrements = true;
+    size_t nSteps = 0;
+    forEachStatement(*loop.body, [&] (Statement& s) {
+        if (auto* assignment = asAssignmentTo(s, index)) {
+            if (!isIncrement(*assignment, index))
+                onlyIncrements = false;
+            nSteps++;
+        }
+    });
+    bool topLevelStep = false;
+    for (auto& s : loop.body->statements)
+        if (asAssignmentTo(*s, index))
+            topLevelStep = true;
+    if (!onlyIncrements || nSteps != 1 || !topLevelStep)
+        return;
+
+    // i != a.length only implies i < a.length if i starts below the
+    // length and never skips over it
+    if (notEquals && (start != 0 || assigns(*loop.body, array)))
+        return;
+
+    LoopAnalysis analysis{ index, array };
+    analysis.markAccesses(*loop.body);
+}
+
+
+/// checks if \p loop has the form <code>for i in c..a.length</code> with <code>c >= 0</code>
+void analyzeForLoop(ForBlock& loop)
+{
+    if (loop.array)
+        return;
+
+    // the length is read once, so the array must stay the same in all
+    // iterations
+    unsigned long long start;
+    Variable* array = getLengthOf(*loop.to);
+    if (array == nullptr || !isNonNegativeConstant(*loop.from, start) ||
+        assigns(*loop.body, array) || assigns(*loop.body, loop.variable))
+        return;
+
+    LoopAnalysis analysis{ loop.variable, array };
+    analysis.markAccesses(*loop.body);
+}
+
+
+void analyzeBlock(DoEndBlock& block)
+{
+    for (size_t i = 0; i < block.statements.size(); i++) {
+        Statement& statement = *block.statements[i];
+        if (auto* loop = dynamic_cast<WhileBlock*>(&statement)) {
+            analyzeLoop(block, i, *loop);
+            analyzeBlock(*loop->body);
+        }
+        else if (auto* loop = dynamic_cast<ForBlock*>(&statement)) {
+            analyzeForLoop(*loop);
+            analyzeBlock(*loop->body);
+        }
+        else if (auto* ifElse = dynamic_cast<IfElseBlock*>(&statement)) {
+            analyzeBlock(*ifElse->ifBlock);
+            if (ifElse->elseBlock)
+                analyzeBlock(*ifElse->elseBlock);
+        }
+        else if (auto* match = dynamic_cast<MatchBlock*>(&statement)) {
+            for (auto& c : match->cases)
+                analyzeBlock(*c.body);
+            if (match->elseBlock)
+                analyzeBlock(*match->elseBlock);
+        }
+        else if (auto* region = dynamic_cast<RegionBlock*>(&statement)) {
+            analyzeBlock(*region->body);
+        }
+        else if (auto* nested = dynamic_cast<DoEndBlock*>(&statement)) {
+            analyzeBlock(*nested);
+        }
+    }
+}
+
+} // namespace
+
+
+void qlow::sem::eliminateBoundsChecks(Method& method)
+{
+    if (!method.body)
+        return;
+
+    // local variables whose address is taken can change behind our back
+    bool addressTaken = false;
+    forEachStatement(*method.body, [&] (Statement& s) {
+        forEachOwnExpression(s, [&] (Expression& e) {
+            forEachExpression(e, [&] (Expression& sub) {
+                if (dynamic_cast<AddressExpression*>(&sub))
+                    addressTaken = true;
+            });
+        });
+    });
+    if (addressTaken)
+        return;
+
+    analyzeBlock(*method.body);
+}
@@ -0,0 +1,32 @@
+#ifndef QLOW_SEM_BOUNDSANALYSIS_H
+#define QLOW_SEM_BOUNDSANALYSIS_H
+
+namespace qlow
+{
+    namespace sem
+    {
+        struct Method;
+
+        /*!
+         * \brief marks array accesses that cannot be out of range
+         *
+         * Recognizes counting loops of the form
+         *
+         *     i := 0
+         *     while i < a.length do
+         *         ... a[i] ...
+         *         i := i + 1
+         *     end
+         *
+         * and clears \ref ArrayAccessExpression::needsBoundsCheck on the
+         * accesses <code>a[i]</code> in the loop body that happen before
+         * <code>i</code> or <code>a</code> are assigned again. The same
+         * holds for <code>for i in 0..a.length</code> if <code>a</code> is
+         * not assigned in the loop.
+         */
+        void eliminateBoundsChecks(Method& method);
+    }
+}
+
+
+#endif // QLOW_SEM_BOUNDSANALYSIS_H
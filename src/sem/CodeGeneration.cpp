@@ -1,10 +1,17 @@
 #include "CodeGeneration.h"
+#include "DebugInfo.h"
 #include "Mangling.h"
 #include "Linking.h"
+#include "Traversal.h"
+#include "Driver.h"
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/LegacyPassManager.h>
-#include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Constants.h>
@@ -12,6 +19,12 @@
 #include <llvm/IR/Verifier.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Attributes.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/InlineAsm.h>
+#include <llvm/IR/GlobalIFunc.h>
+#include <llvm/ADT/Triple.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/Support/TargetSelect.h>
@@ -19,18 +32,321 @@
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/CodeGen.h>
 #include <llvm/Support/raw_os_ostream.h>
+#include <llvm/Support/Regex.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/LLVMRemarkStreamer.h>
+#include <llvm/Remarks/RemarkStreamer.h>
+#include <llvm/CodeGen/MachineOptimizationRemarkEmitter.h>
+#include <llvm/ADT/SmallString.h>
 
+#include <mutex>
+#include <algorithm>
+#include <iomanip>
 
-using namespace qlow;
 
-static llvm::LLVMContext context;
+using namespace qlow;
 
 namespace qlow
 {
 namespace gen
 {
 
-std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
+/// declares a function of the c library, unless it is already declared
+static llvm::Function* getExternalFunction(llvm::Module* module,
+    const std::string& name, llvm::FunctionType* type)
+{
+    std::string symbol = qlow::getExternalSymbol(name);
+    if (llvm::Function* function = module->getFunction(symbol))
+        return function;
+    return llvm::Function::Create(type, llvm::Function::ExternalLinkage, symbol, module);
+}
+
+
+/// returns the cpu selected with -mcpu or -march, resolving "native"
+static std::string getTargetCpu(const Options& options)
+{
+    if (options.targetCpu.empty())
+        return "generic";
+    if (options.targetCpu == "native")
+        return llvm::sys::getHostCPUName().str();
+    return options.targetCpu;
+}
+
+
+/// returns the features of the host cpu for "native" and those given with -mattr
+static std::string getTargetFeatures(const Options& options)
+{
+    std::string features;
+    if (options.targetCpu == "native") {
+        llvm::StringMap<bool> hostFeatures;
+        if (llvm::sys::getHostCPUFeatures(hostFeatures)) {
+            for (const auto& feature : hostFeatures) {
+                if (!features.empty())
+                    features += ",";
+                features += (feature.second ? "+" : "-") + feature.first().str();
+            }
+        }
+    }
+    if (!options.targetFeatures.empty()) {
+        if (!features.empty())
+            features += ",";
+        features += options.targetFeatures;
+    }
+    return features;
+}
+
+
+/// creates the target machine for the host with the cpu and features of the options
+static std::unique_ptr<llvm::TargetMachine> createTargetMachine(const Options& options)
+{
+    // target registration is not thread safe
+    static std::once_flag targetsInitialized;
+    std::call_once(targetsInitialized, [] () {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+    //llvm::InitializeAllTargetInfos();
+    //llvm::InitializeAllTargets();
+    //llvm::InitializeAllTargetMCs();
+    //llvm::InitializeAllAsmParsers();
+    //llvm::InitializeAllAsmPrinters();
+
+    std::string cpu = getTargetCpu(options);
+    std::string features = getTargetFeatures(options);
+
+    std::string error;
+    std::string targetTriple = llvm::sys::getDefaultTargetTriple();
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+
+    if (!target) {
+#ifdef DEBUGGING
+        Printer::getInstance() << "could not create target: " << error << std::endl;
+#endif
+        throw "internal error";
+    }
+
+    llvm::TargetOptions targetOptions;
+    targetOptions.FunctionSections = true;
+    if (options.fpContract)
+        targetOptions.AllowFPOpFusion = llvm::FPOpFusion::Fast;
+    auto relocModel = llvm::Optional<llvm::Reloc::Model>(llvm::Reloc::Model::PIC_);
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(targetTriple, cpu,
+            features, targetOptions, relocModel));
+}
+
+
+/// x86 cpu feature that a function can be cloned for
+struct CpuFeature
+{
+    const char* name;
+    unsigned cpuidLeaf;
+    /// index of the cpuid result register: eax, ebx, ecx, edx
+    unsigned cpuidRegister;
+    unsigned bit;
+    /// register state the os has to save, as reported by xgetbv
+    uint32_t xcr0Mask;
+};
+
+/// ordered by preference, the last supported feature is chosen
+static const CpuFeature cpuFeatures[] = {
+    { "sse4.2",     1, 2, 20, 0 },
+    { "popcnt",     1, 2, 23, 0 },
+    { "avx",        1, 2, 28, 0x6 },
+    { "fma",        1, 2, 12, 0x6 },
+    { "bmi2",       7, 1, 8,  0 },
+    { "avx2",       7, 1, 5,  0x6 },
+    { "avx512f",    7, 1, 16, 0xe6 },
+};
+
+
+/*!
+ * \brief generates a resolver that returns the best of \p versions for the
+ *        running cpu
+ *
+ * \param versions the clones for some of \ref cpuFeatures, indexed like it
+ */
+static void generateResolver(llvm::Function* resolver, llvm::Function* defaultVersion,
+    const std::vector<llvm::Function*>& versions)
+{
+    using llvm::Value;
+    llvm::LLVMContext& context = resolver->getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::Type* i32 = builder.getInt32Ty();
+
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", resolver);
+    llvm::BasicBlock* readXcr0 = llvm::BasicBlock::Create(context, "xgetbv", resolver);
+    llvm::BasicBlock* select = llvm::BasicBlock::Create(context, "select", resolver);
+
+    auto* cpuidResult = llvm::StructType::get(context, { i32, i32, i32, i32 });
+    auto* cpuid = llvm::InlineAsm::get(llvm::FunctionType::get(cpuidResult, { i32, i32 }, false),
+        "cpuid", "={ax},={bx},={cx},={dx},{ax},{cx},~{dirflag},~{fpsr},~{flags}", false);
+    auto* xgetbvResult = llvm::StructType::get(context, { i32, i32 });
+    auto* xgetbv = llvm::InlineAsm::get(llvm::FunctionType::get(xgetbvResult, { i32 }, false),
+        "xgetbv", "={ax},={dx},{cx},~{dirflag},~{fpsr},~{flags}", false);
+
+    builder.SetInsertPoint(entry);
+    Value* maxLeaf = builder.CreateExtractValue(
+        builder.CreateCall(cpuid, { builder.getInt32(0), builder.getInt32(0) }), { 0 });
+    Value* leaf1 = builder.CreateCall(cpuid, { builder.getInt32(1), builder.getInt32(0) });
+    Value* leaf7 = builder.CreateCall(cpuid, { builder.getInt32(7), builder.getInt32(0) });
+    // leaf 7 returns garbage on cpus that do not have it
+    Value* hasLeaf7 = builder.CreateICmpUGE(maxLeaf, builder.getInt32(7));
+
+    // xgetbv faults unless the os has enabled it, which cpuid reports in osxsave
+    Value* osxsave = builder.CreateAnd(builder.CreateExtractValue(leaf1, { 2 }),
+        builder.getInt32(1u << 27));
+    builder.CreateCondBr(builder.CreateICmpNE(osxsave, builder.getInt32(0)), readXcr0, select);
+
+    builder.SetInsertPoint(readXcr0);
+    Value* xcr0Value = builder.CreateExtractValue(
+        builder.CreateCall(xgetbv, { builder.getInt32(0) }), { 0 });
+    builder.CreateBr(select);
+
+    builder.SetInsertPoint(select);
+    llvm::PHINode* xcr0 = builder.CreatePHI(i32, 2, "xcr0");
+    xcr0->addIncoming(builder.getInt32(0), entry);
+    xcr0->addIncoming(xcr0Value, readXcr0);
+
+    Value* result = defaultVersion;
+    for (size_t i = 0; i < versions.size(); i++) {
+        if (versions[i] == nullptr)
+            continue;
+        const CpuFeature& feature = cpuFeatures[i];
+        Value* leaf = feature.cpuidLeaf == 1 ? leaf1 : leaf7;
+        Value* mask = builder.getInt32(1u << feature.bit);
+        Value* bits = builder.CreateAnd(builder.CreateExtractValue(leaf, { feature.cpuidRegister }), mask);
+        Value* supported = builder.CreateICmpEQ(bits, mask);
+        if (feature.cpuidLeaf == 7)
+            supported = builder.CreateAnd(supported, hasLeaf7);
+        if (feature.xcr0Mask != 0) {
+            Value* xcr0Mask = builder.getInt32(feature.xcr0Mask);
+            supported = builder.CreateAnd(supported,
+                builder.CreateICmpEQ(builder.CreateAnd(xcr0, xcr0Mask), xcr0Mask));
+        }
+        result = builder.CreateSelect(supported, versions[i], result);
+    }
+    builder.CreateRet(result);
+}
+
+
+/*!
+ * \brief replaces the function of \p method by an ifunc choosing between
+ *        versions compiled for the features in its <code>@target_clones</code>
+ *
+ * The version without additional features is always generated, also if
+ * "default" is not given. The dynamic loader runs the resolver once and
+ * binds all calls to the chosen version.
+ */
+static void generateTargetClones(CodegenSession& session, llvm::Module* module,
+    const sem::Method& method)
+{
+    const CodePosition& pos = method.astNode ? method.astNode->pos : CodePosition::none();
+    if (llvm::Triple(llvm::sys::getDefaultTargetTriple()).getArch() != llvm::Triple::x86_64) {
+        throw SemanticError(SemanticError::INVALID_ANNOTATION,
+            "'@target_clones' is only supported on x86-64", pos);
+    }
+
+    const size_t nFeatures = sizeof cpuFeatures / sizeof cpuFeatures[0];
+    std::vector<bool> requested(nFeatures, false);
+    for (const auto& target : method.targetClones) {
+        if (target == "default")
+            continue;
+        auto* feature = std::find_if(std::begin(cpuFeatures), std::end(cpuFeatures),
+            [&target] (const CpuFeature& f) { return target == f.name; });
+        if (feature == std::end(cpuFeatures)) {
+            throw SemanticError(SemanticError::INVALID_ANNOTATION,
+                "unknown cpu feature '" + target + "' in '@target_clones'", pos);
+        }
+        requested[feature - std::begin(cpuFeatures)] = true;
+    }
+
+    llvm::Function* function = session.getFunction(&method);
+    std::string name = function->getName().str();
+    llvm::FunctionType* functionType = function->getFunctionType();
+
+    llvm::Function* resolver = llvm::Function::Create(
+        llvm::FunctionType::get(function->getType(), false),
+        llvm::Function::InternalLinkage, name + ".resolver", module);
+    llvm::GlobalIFunc* ifunc = llvm::GlobalIFunc::create(functionType,
+        function->getAddressSpace(), function->getLinkage(), "", resolver, module);
+
+    // the version without added features keeps the body, recursive calls in
+    // the clones go through the ifunc as well
+    function->replaceAllUsesWith(ifunc);
+    function->setName(name + ".default");
+    function->setLinkage(llvm::Function::InternalLinkage);
+    ifunc->setName(name);
+
+    std::string baseFeatures;
+    if (function->hasFnAttribute("target-features"))
+        baseFeatures = function->getFnAttribute("target-features").getValueAsString().str() + ",";
+
+    std::vector<llvm::Function*> versions(nFeatures, nullptr);
+    for (size_t i = 0; i < nFeatures; i++) {
+        if (!requested[i])
+            continue;
+        llvm::ValueToValueMapTy valueMap;
+        llvm::Function* clone = llvm::CloneFunction(function, valueMap);
+        clone->setName(name + "." + cpuFeatures[i].name);
+        clone->addFnAttr("target-features", baseFeatures + "+" + cpuFeatures[i].name);
+        versions[i] = clone;
+    }
+
+    generateResolver(resolver, function, versions);
+}
+
+
+/// prints the size, the field offsets and the padding of every class
+static void printLayouts(CodegenSession& session, sem::GlobalScope& semantic)
+{
+    Printer& printer = Printer::getInstance();
+    const llvm::DataLayout& layout = session.getDataLayout();
+
+    for (auto& [name, semClass] : semantic.classes) {
+        llvm::Type* type = session.getLlvmType(semClass->classType);
+        auto* structType = llvm::cast<llvm::StructType>(semClass->isReferenceType ?
+            type->getPointerElementType() : type);
+        const llvm::StructLayout* structLayout = layout.getStructLayout(structType);
+
+        std::vector<sem::Field*> fields = semClass->fieldOrder;
+        auto offsetOf = [&] (const sem::Field* field) {
+            return structLayout->getElementOffset(session.getStructIndex(field));
+        };
+        std::stable_sort(fields.begin(), fields.end(), [&] (sem::Field* a, sem::Field* b) {
+            return offsetOf(a) < offsetOf(b);
+        });
+
+        uint64_t size = structLayout->getSizeInBytes();
+        uint64_t used = 0;
+        for (auto* field : fields)
+            used += layout.getTypeAllocSize(session.getLlvmType(field->type));
+
+        printer << (semClass->isReferenceType ? "class " : "struct ") << name << ": "
+            << size << " bytes, aligned to " << session.getStructAlignment(semClass->classType)
+            << ", " << size - used << " bytes of padding" << std::endl;
+
+        auto printLine = [&] (uint64_t offset, uint64_t bytes, const std::string& what) {
+            printer << std::setw(8) << offset << std::setw(6) << bytes << "  " << what << std::endl;
+        };
+        uint64_t end = 0;
+        for (auto* field : fields) {
+            uint64_t offset = offsetOf(field);
+            if (offset > end)
+                printLine(end, offset - end, "(padding)");
+            uint64_t bytes = layout.getTypeAllocSize(session.getLlvmType(field->type));
+            printLine(offset, bytes, field->name + ": " + field->type->asString());
+            end = offset + bytes;
+        }
+        if (size > end)
+            printLine(end, size - end, "(padding)");
+    }
+}
+
+
+std::unique_ptr<llvm::Module> generateModule(CodegenSession& session, sem::GlobalScope& semantic)
 {
     using llvm::Module;
     using llvm::Function;
@@ -42,6 +358,7 @@ std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
     using llvm::IRBuilder;
     
     Printer& printer = Printer::getInstance();
+    llvm::LLVMContext& context = session.getLlvmContext();
     
 #ifdef DEBUGGING
         printf("creating llvm module\n"); 
@@ -49,17 +366,60 @@ std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
 
     std::unique_ptr<Module> module = std::make_unique<Module>("qlow_module", context);
 
-    // create llvm structs
-    // TODO implement detection of circles
-    semantic.getContext().createLlvmTypes(context);
-    
+    // struct layouts, the calling convention and the debug information
+    // depend on the data layout of the target
+    const Options& options = session.getOptions();
+    {
+        std::unique_ptr<llvm::TargetMachine> targetMachine = createTargetMachine(options);
+        module->setTargetTriple(targetMachine->getTargetTriple().str());
+        module->setDataLayout(targetMachine->createDataLayout());
+    }
+    session.setDataLayout(module->getDataLayout());
+    if (options.printLayouts)
+        printLayouts(session, semantic);
+
+    // the system calls of the runtime are only implemented for x86-64 linux,
+    // on other targets the C library is linked statically
+    llvm::Triple triple{ module->getTargetTriple() };
+    session.setFreestanding(options.staticLink && triple.getArch() == llvm::Triple::x86_64 &&
+        triple.isOSLinux() && !needsCLibrary(options, semantic));
+
+    std::unique_ptr<DebugInfoGenerator> debugInfo;
+    if (options.debugInfo != Options::DebugInfo::NONE || options.hasRemarks())
+        debugInfo = std::make_unique<DebugInfoGenerator>(session, *module);
+
     llvm::AttrBuilder ab;
-    ab.addAttribute(llvm::Attribute::AttrKind::NoInline);
     ab.addAttribute(llvm::Attribute::AttrKind::NoUnwind);
     //ab.addAttribute(llvm::Attribute::AttrKind::OptimizeNone);
     //ab.addAttribute(llvm::Attribute::AttrKind::UWTable);
     ab.addAttribute("no-frame-pointer-elim", "true");
     ab.addAttribute("no-frame-pointer-elim-non-leaf");
+
+    // the backend reads the floating point relaxations from these
+    if (options.fastMath)
+        ab.addAttribute("unsafe-fp-math", "true");
+    if (options.finiteMath) {
+        ab.addAttribute("no-nans-fp-math", "true");
+        ab.addAttribute("no-infs-fp-math", "true");
+    }
+    if (options.noSignedZeros)
+        ab.addAttribute("no-signed-zeros-fp-math", "true");
+
+    // keeps the optimizer from turning loops into calls to memset and
+    // memcpy, which the runtime only provides for the backend
+    if (session.isFreestanding())
+        ab.addAttribute("no-builtins");
+
+    if (options.sizeLevel >= 1)
+        ab.addAttribute(llvm::Attribute::AttrKind::OptimizeForSize);
+    if (options.sizeLevel == 2)
+        ab.addAttribute(llvm::Attribute::AttrKind::MinSize);
+
+    // the inliner only inlines between functions with compatible targets
+    ab.addAttribute("target-cpu", getTargetCpu(options));
+    std::string features = getTargetFeatures(options);
+    if (!features.empty())
+        ab.addAttribute("target-features", features);
     llvm::AttributeSet as = llvm::AttributeSet::get(context, ab);
     
     
@@ -69,7 +429,7 @@ std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
     // create all llvm functions
     for (const auto& [name, cl] : semantic.getClasses()) {
         for (const auto& [name, method] : cl->methods) {
-            Function* func = generateFunction(module.get(), method.get());
+            Function* func = generateFunction(session, module.get(), method.get());
             for (auto a : as) {
                 func->addFnAttr(a);
             }
@@ -78,7 +438,7 @@ std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
     }
     
     for (const auto& [name, method] : semantic.getMethods()) {
-        Function* func = generateFunction(module.get(), method.get());
+        Function* func = generateFunction(session, module.get(), method.get());
         for (auto a : as) {
             func->addFnAttr(a);
         }
@@ -90,7 +450,7 @@ std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
             if (!method->body)
                 continue;
             
-            FunctionGenerator fg(*method, module.get(), as);
+            FunctionGenerator fg(session, *method, module.get(), as, debugInfo.get());
             Function* f = fg.generate();
 //            printer << "verifying function: " << method->name << std::endl;
             bool corrupt = llvm::verifyFunction(*f, &verifyStream);
@@ -109,7 +469,7 @@ std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
         if (!method->body)
             continue;
         
-        FunctionGenerator fg(*method, module.get(), as);
+        FunctionGenerator fg(session, *method, module.get(), as, debugInfo.get());
         Function* f = fg.generate();
         //printer.debug() << "verifying function: " << method->name << std::endl;
         bool corrupt = llvm::verifyFunction(*f, &verifyStream);
@@ -123,34 +483,71 @@ std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& semantic)
     }
     auto mainMethod = semantic.getMethod("main");
     if (mainMethod != nullptr) {
-        generateStartFunction(module.get(), mainMethod->llvmNode);
+        Function* start = generateStartFunction(session, module.get(),
+            session.getFunction(mainMethod));
+        // main is inlined into the entry point, which therefore needs a
+        // subprogram as well
+        if (debugInfo && mainMethod->astNode != nullptr)
+            debugInfo->createArtificialSubprogram(start, mainMethod->astNode->pos);
+    }
+    if (session.isFreestanding())
+        generateRuntimeFunctions(module.get());
+    if (debugInfo)
+        debugInfo->finalize();
+
+    // cloning is done last, so that all calls are redirected to the dispatcher
+    for (const auto& [name, cl] : semantic.getClasses()) {
+        for (const auto& [name, method] : cl->methods) {
+            if (method->body && !method->targetClones.empty())
+                generateTargetClones(session, module.get(), *method);
+        }
+    }
+    for (const auto& [name, method] : semantic.getMethods()) {
+        if (method->body && !method->targetClones.empty())
+            generateTargetClones(session, module.get(), *method);
     }
     return module;
 }
 
 
-llvm::Function* generateFunction(llvm::Module* module, sem::Method* method)
+llvm::Function* generateFunction(CodegenSession& session, llvm::Module* module, sem::Method* method)
 {
     sem::Context& semCtxt = method->context;
+    llvm::LLVMContext& context = session.getLlvmContext();
     using llvm::Function;
     using llvm::Argument;
     using llvm::Type;
     using llvm::FunctionType;
     
+    const llvm::DataLayout& layout = module->getDataLayout();
+
     Type* returnType;
     if (method->returnType)
-        returnType = method->returnType->getLlvmType(context);
+        returnType = session.getLlvmType(method->returnType);
     else
         returnType = llvm::Type::getVoidTy(context);
+
+    bool returnsInMemory = method->returnType != nullptr &&
+        session.isPassedInMemory(method->returnType, layout);
     
     std::vector<Type*> argumentTypes;
+    if (returnsInMemory) {
+        argumentTypes.push_back(returnType->getPointerTo());
+        returnType = llvm::Type::getVoidTy(context);
+    }
+
     if (method->thisExpression != nullptr) {
-        Type* enclosingType = method->thisExpression->type->getLlvmType(context);
+        Type* enclosingType = session.getLlvmType(method->thisExpression->type);
+        // methods of structs work on the struct in place
+        if (method->thisExpression->type->isStructType())
+            enclosingType = enclosingType->getPointerTo();
         argumentTypes.push_back(enclosingType);
     }
     
     for (auto& arg : method->arguments) {
-        Type* argumentType = arg->type->getLlvmType(context);
+        Type* argumentType = session.getLlvmType(arg->type);
+        if (session.isPassedInMemory(arg->type, layout))
+            argumentType = argumentType->getPointerTo();
         argumentTypes.push_back(argumentType);
     }
     
@@ -163,12 +560,73 @@ llvm::Function* generateFunction(llvm::Module* module, sem::Method* method)
         throw "invalid return type";
     std::string symbolName = method->getMangledName();
     Function* func = Function::Create(funcType, Function::ExternalLinkage, symbolName, module);
-    method->llvmNode = func;
+    session.setFunction(method, func);
+
+    unsigned argNo = 0;
+    if (returnsInMemory) {
+#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 12
+        func->addParamAttr(argNo, llvm::Attribute::getWithStructRetType(context,
+            session.getLlvmType(method->returnType)));
+#else
+        func->addParamAttr(argNo, llvm::Attribute::AttrKind::StructRet);
+#endif
+        func->addParamAttr(argNo, llvm::Attribute::AttrKind::NoAlias);
+        argNo++;
+    }
+    if (method->thisExpression != nullptr)
+        argNo++;
+    for (auto& arg : method->arguments) {
+        if (session.isPassedInMemory(arg->type, layout)) {
+#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 9
+            func->addParamAttr(argNo, llvm::Attribute::getWithByValType(context,
+                session.getLlvmType(arg->type)));
+#else
+            func->addParamAttr(argNo, llvm::Attribute::AttrKind::ByVal);
+#endif
+            // the copy of an @align struct must be aligned like the original
+            unsigned alignment = session.getAlignment(arg->type);
+            if (alignment > layout.getABITypeAlign(session.getLlvmType(arg->type)).value())
+                func->addParamAttr(argNo, llvm::Attribute::getWithAlignment(context, llvm::Align(alignment)));
+        }
+        argNo++;
+    }
+
+    switch (method->inlining) {
+    case sem::Method::Inlining::DEFAULT:
+        break;
+    case sem::Method::Inlining::INLINE:
+        func->addFnAttr(llvm::Attribute::AttrKind::InlineHint);
+        break;
+    case sem::Method::Inlining::NO_INLINE:
+        func->addFnAttr(llvm::Attribute::AttrKind::NoInline);
+        break;
+    case sem::Method::Inlining::ALWAYS_INLINE:
+        func->addFnAttr(llvm::Attribute::AttrKind::AlwaysInline);
+        break;
+    }
+
+    // the section prefix groups hot and cold functions together when
+    // emitting each function into its own section
+    switch (method->hotness) {
+    case sem::Method::Hotness::DEFAULT:
+        break;
+    case sem::Method::Hotness::HOT:
+        func->addFnAttr(llvm::Attribute::AttrKind::Hot);
+        func->setSectionPrefix("hot");
+        break;
+    case sem::Method::Hotness::COLD:
+        func->addFnAttr(llvm::Attribute::AttrKind::Cold);
+        func->addFnAttr(llvm::Attribute::AttrKind::OptimizeForSize);
+        func->setSectionPrefix("unlikely");
+        break;
+    }
     
     // linking alloca instances for funcs
     auto argIterator = func->arg_begin();
+    if (returnsInMemory)
+        argIterator++;
     if (method->thisExpression != nullptr) {
-        method->thisExpression->allocaInst = &*argIterator;
+        session.setVariable(method->thisExpression, &*argIterator);
 #ifdef DEBUGGING
         Printer::getInstance() << "allocaInst of this";
 #endif
@@ -179,9 +637,9 @@ llvm::Function* generateFunction(llvm::Module* module, sem::Method* method)
     for (; argIterator != func->arg_end(); argIterator++) {
         if (argIndex > method->arguments.size())
             throw "internal error";
-        method->arguments[argIndex]->allocaInst = &*argIterator;
+        session.setVariable(method->arguments[argIndex], &*argIterator);
 #ifdef DEBUGGING
-        printf("allocaInst of arg '%s': %p\n", method->arguments[argIndex]->name.c_str(), (void*)method->arguments[argIndex]->allocaInst);
+        printf("allocaInst of arg '%s': %p\n", method->arguments[argIndex]->name.c_str(), (void*)&*argIterator);
 #endif 
         argIndex++;
     }
@@ -192,7 +650,53 @@ llvm::Function* generateFunction(llvm::Module* module, sem::Method* method)
 
 
 
-llvm::Function* generateStartFunction(llvm::Module* module, llvm::Function* start)
+/// emits a linux x86-64 system call with up to six arguments
+static llvm::Value* createSyscall(llvm::IRBuilder<>& builder, long number,
+    const std::vector<llvm::Value*>& args)
+{
+    static const char* const registers[] = { "{di}", "{si}", "{dx}", "{r10}", "{r8}", "{r9}" };
+    std::string constraints = "={ax},{ax}";
+    std::vector<llvm::Type*> types = { builder.getInt64Ty() };
+    std::vector<llvm::Value*> operands = { builder.getInt64(number) };
+    for (size_t i = 0; i < args.size(); i++) {
+        constraints += std::string(",") + registers[i];
+        types.push_back(args[i]->getType());
+        operands.push_back(args[i]);
+    }
+    // the kernel overwrites rcx and r11
+    constraints += ",~{rcx},~{r11},~{memory},~{dirflag},~{fpsr},~{flags}";
+    auto* syscall = llvm::InlineAsm::get(
+        llvm::FunctionType::get(builder.getInt64Ty(), types, false), "syscall", constraints, true);
+    return builder.CreateCall(syscall, operands);
+}
+
+
+/// terminates the process using <code>exit_group</code>
+static void createExit(llvm::IRBuilder<>& builder, llvm::Value* status)
+{
+    const long exitGroup = 231;
+    createSyscall(builder, exitGroup, { builder.CreateSExt(status, builder.getInt64Ty()) });
+    builder.CreateUnreachable();
+}
+
+
+/*!
+ * \brief generates the entry point of the program, which calls \p start
+ *        and exits with its return value
+ *
+ * The entry point is <code>_qlow_start</code>, which the kernel or the
+ * dynamic loader jump to directly. Freestanding programs exit using a
+ * system call, the others using <code>exit</code> of the C library.
+ * Statically linked programs using the C library get a C <code>main</code>
+ * instead, as the static C library has to be initialized by its startup
+ * files.
+ *
+ * With <code>-fprofile-generate</code>, the profile runtime is initialized
+ * before and the profile written after \p start. As <code>_qlow_start</code>
+ * bypasses the initialization of the C library, the runtime cannot
+ * register itself in a constructor.
+ */
+llvm::Function* generateStartFunction(CodegenSession& session, llvm::Module* module, llvm::Function* start)
 {
     using llvm::Function;
     using llvm::FunctionType;
@@ -201,182 +705,1696 @@ llvm::Function* generateStartFunction(llvm::Module* module, llvm::Function* star
     using llvm::BasicBlock;
     using llvm::Value;
 
-    FunctionType* startFuncType = FunctionType::get(
-        Type::getVoidTy(context), { Type::getInt32Ty(context), Type::getInt8PtrTy(context)->getPointerTo() }, false);
-    FunctionType* exitFuncType = FunctionType::get(
-        Type::getVoidTy(context), { Type::getInt32Ty(context) }, false);
-    Function* startFunction = Function::Create(startFuncType, Function::ExternalLinkage, "_qlow_start", module);
-    Function* exitFunction = Function::Create(exitFuncType, Function::ExternalLinkage, qlow::getExternalSymbol("exit"), module);
+    const Options& options = session.getOptions();
+    bool cMain = options.staticLink && !session.isFreestanding();
 
+    llvm::LLVMContext& context = module->getContext();
+    Type* int32 = Type::getInt32Ty(context);
+    FunctionType* startFuncType = FunctionType::get(
+        cMain ? int32 : Type::getVoidTy(context), { int32, Type::getInt8PtrTy(context)->getPointerTo() }, false);
+    Function* startFunction = Function::Create(startFuncType, Function::ExternalLinkage,
+        cMain ? qlow::getExternalSymbol("main") : "_qlow_start", module);
+    // no return address is pushed when jumping to the entry point, so the
+    // stack is misaligned by 8 bytes
+    if (!cMain)
+        startFunction->addFnAttr("stackrealign");
 
     IRBuilder<> builder(context);
     BasicBlock* bb = BasicBlock::Create(context, "entry", startFunction);
     builder.SetInsertPoint(bb);
+    if (options.profileGenerate) {
+        FunctionType* initType = FunctionType::get(Type::getVoidTy(context), false);
+        builder.CreateCall(getExternalFunction(module, "__llvm_profile_initialize_file", initType), {});
+    }
     auto returnVal = builder.CreateCall(start, {});
+    if (options.profileGenerate) {
+        FunctionType* writeType = FunctionType::get(Type::getInt32Ty(context), false);
+        builder.CreateCall(getExternalFunction(module, "__llvm_profile_write_file", writeType), {});
+    }
 
-    if (start->getReturnType()->isIntegerTy()) {
-        auto rv = builder.CreateIntCast(returnVal, llvm::Type::getInt32Ty(context), true);
-        builder.CreateCall(exitFunction, { rv });
+    Value* status = llvm::ConstantInt::get(context, llvm::APInt(32, "0", 10));
+    if (start->getReturnType()->isIntegerTy())
+        status = builder.CreateIntCast(returnVal, int32, true);
+
+    if (cMain) {
+        builder.CreateRet(status);
+    }
+    else if (session.isFreestanding()) {
+        createExit(builder, status);
     }
     else {
-        builder.CreateCall(exitFunction, { llvm::ConstantInt::get(context, llvm::APInt(32, "0", 10)) });
+        FunctionType* exitFuncType = FunctionType::get(Type::getVoidTy(context), { int32 }, false);
+        builder.CreateCall(getExternalFunction(module, "exit", exitFuncType), { status });
+        builder.CreateRetVoid();
     }
-    builder.CreateRetVoid();
 
     return startFunction;
 }
 
 
-void generateObjectFile(const std::string& filename, std::unique_ptr<llvm::Module> module, int optLevel)
+llvm::Function* generateBoundsErrorHandler(CodegenSession& session, llvm::Module* module)
 {
-    using llvm::legacy::PassManager;
-    using llvm::PassManagerBuilder;
-    using llvm::raw_fd_ostream;
-    using llvm::Target;
-    using llvm::TargetMachine;
-    using llvm::TargetRegistry;
-    using llvm::TargetOptions;
+    using llvm::Function;
+    using llvm::FunctionType;
+    using llvm::Type;
+    using llvm::BasicBlock;
 
-    Printer& printer = Printer::getInstance();
-#ifdef DEBUGGING
-    printer << "verifying mod" << std::endl;
-#endif
-    auto ostr = llvm::raw_os_ostream(printer);
-#ifdef DEBUGGING
-    module->print(ostr, nullptr);
-#endif
-    bool broken = llvm::verifyModule(*module);
-    
-    if (broken)
-        throw "invalid llvm module";
-    
-    llvm::InitializeNativeTarget ();
-    llvm::InitializeNativeTargetAsmPrinter();
-    //llvm::InitializeAllTargetInfos();
-    //llvm::InitializeAllTargets();
-    //llvm::InitializeAllTargetMCs();
-    //llvm::InitializeAllAsmParsers();
-    //llvm::InitializeAllAsmPrinters();
+    const char handlerName[] = "_qlow_bounds_error";
+    if (Function* handler = module->getFunction(handlerName))
+        return handler;
 
-    PassManager pm;
-    
-    int sizeLevel = 0;
-    PassManagerBuilder builder;
-    builder.OptLevel = optLevel;
-    builder.SizeLevel = sizeLevel;
-    if (optLevel >= 2) {
-        //builder.DisableUnitAtATime = false;
-        builder.DisableUnrollLoops = false;
-        builder.LoopVectorize = true;
-        builder.SLPVectorize = true;
+    llvm::LLVMContext& context = module->getContext();
+    Type* int64 = Type::getInt64Ty(context);
+    Type* int32 = Type::getInt32Ty(context);
+    FunctionType* handlerType = FunctionType::get(
+        Type::getVoidTy(context), { int64, int64 }, false);
+
+    Function* handler = Function::Create(handlerType, Function::InternalLinkage, handlerName, module);
+    handler->addFnAttr(llvm::Attribute::AttrKind::Cold);
+    handler->addFnAttr(llvm::Attribute::AttrKind::NoReturn);
+    handler->addFnAttr(llvm::Attribute::AttrKind::NoInline);
+    handler->addFnAttr(llvm::Attribute::AttrKind::NoUnwind);
+    handler->addFnAttr(llvm::Attribute::AttrKind::OptimizeForSize);
+    handler->setSectionPrefix("unlikely");
+
+    llvm::IRBuilder<> builder(context);
+    builder.SetInsertPoint(BasicBlock::Create(context, "entry", handler));
+
+    // without printf, the message does not contain the index and length
+    if (session.isFreestanding()) {
+        const char text[] = "array index out of bounds\n";
+        const long write = 1;
+        auto* message = builder.CreateGlobalStringPtr(text, "boundserrormessage");
+        createSyscall(builder, write,
+            { builder.getInt64(2), message, builder.getInt64(sizeof text - 1) });
+        createExit(builder, builder.getInt32(1));
+        return handler;
     }
 
-    builder.populateModulePassManager(pm);
+    FunctionType* dprintfType = FunctionType::get(
+        int32, { int32, Type::getInt8PtrTy(context) }, true);
+    FunctionType* exitType = FunctionType::get(
+        Type::getVoidTy(context), { int32 }, false);
+    auto* message = builder.CreateGlobalStringPtr(
+        "index %lld out of bounds for array of length %lld\n", "boundserrormessage");
+    auto argIterator = handler->arg_begin();
+    llvm::Value* index = &*argIterator++;
+    llvm::Value* length = &*argIterator;
+    builder.CreateCall(getExternalFunction(module, "dprintf", dprintfType),
+        { llvm::ConstantInt::get(int32, 2), message, index, length });
+    builder.CreateCall(getExternalFunction(module, "exit", exitType),
+        { llvm::ConstantInt::get(int32, 1) });
+    builder.CreateUnreachable();
 
-    const char cpu[] = "generic";
-    const char features[] = "";
+    return handler;
+}
 
-    std::string error;
-    std::string targetTriple = llvm::sys::getDefaultTargetTriple();
-    const Target* target = TargetRegistry::lookupTarget(targetTriple, error);
 
-    if (!target) {
-#ifdef DEBUGGING
-        printer << "could not create target: " << error << std::endl;
-#endif
-        throw "internal error";
-    }
+llvm::StructType* getRegionType(llvm::LLVMContext& context)
+{
+    llvm::Type* bytePtr = llvm::Type::getInt8PtrTy(context);
+    return llvm::StructType::get(context, { bytePtr, bytePtr, bytePtr, bytePtr });
+}
 
-    TargetOptions targetOptions;
-    auto relocModel = llvm::Optional<llvm::Reloc::Model>(llvm::Reloc::Model::PIC_);
-    TargetMachine* targetMachine = target->createTargetMachine(targetTriple, cpu,
-            features, targetOptions, relocModel);
 
-    std::error_code errorCode;
+/*!
+ * \brief returns the global pointing to the innermost region
+ *
+ * Outside of regions, it is null and objects are allocated with
+ * <code>malloc</code>. Freestanding modules have no heap, so they start
+ * with a region that is never freed.
+ */
+llvm::GlobalVariable* getCurrentRegion(CodegenSession& session, llvm::Module* module)
+{
+    const char name[] = "_qlow_region";
+    if (llvm::GlobalVariable* current = module->getNamedGlobal(name))
+        return current;
 
-    raw_fd_ostream dest(filename, errorCode, llvm::sys::fs::F_None);
-#ifdef DEBUGGING
-    printer << "adding passes" << std::endl;
-#endif
-    targetMachine->addPassesToEmitFile(pm, dest,
-//        llvm::LLVMTargetMachine::CGFT_ObjectFile,
-#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 7
-            nullptr,
-#endif
-//        nullptr,
-        llvm::CGFT_ObjectFile);
+    llvm::StructType* regionType = getRegionType(module->getContext());
+    llvm::Constant* initial = llvm::ConstantPointerNull::get(regionType->getPointerTo());
+    if (session.isFreestanding()) {
+        initial = new llvm::GlobalVariable(*module, regionType, false,
+            llvm::GlobalValue::InternalLinkage, llvm::Constant::getNullValue(regionType),
+            "_qlow_heap");
+    }
+    return new llvm::GlobalVariable(*module, regionType->getPointerTo(), false,
+        llvm::GlobalValue::InternalLinkage, initial, name);
+}
 
-    pm.run(*module);
-    dest.flush();
-    dest.close();
 
-    return;
+/// size of the chunks regions allocate from, unless an object is larger
+static const uint64_t regionChunkSize = 64 * 1024;
+/// the previous chunk and the size of the chunk are stored in front of it
+static const uint64_t regionChunkHeader = 16;
+
+
+/// allocates memory for a chunk using <code>mmap</code> or <code>malloc</code>
+static llvm::Value* createChunkAllocation(CodegenSession& session, llvm::Module* module,
+    llvm::IRBuilder<>& builder, llvm::Value* size)
+{
+    if (session.isFreestanding()) {
+        const long mmap = 9;
+        const long readWrite = 0x3;
+        const long privateAnonymous = 0x22;
+        llvm::Value* address = createSyscall(builder, mmap, { builder.getInt64(0), size,
+            builder.getInt64(readWrite), builder.getInt64(privateAnonymous),
+            builder.getInt64(-1), builder.getInt64(0) });
+        return builder.CreateIntToPtr(address, builder.getInt8PtrTy());
+    }
+    llvm::FunctionType* mallocType = llvm::FunctionType::get(builder.getInt8PtrTy(),
+        { builder.getInt64Ty() }, false);
+    return builder.CreateCall(getExternalFunction(module, "malloc", mallocType), { size });
 }
 
-} // namespace gen
-} // namespace qlow
+
+static void createChunkFree(CodegenSession& session, llvm::Module* module,
+    llvm::IRBuilder<>& builder, llvm::Value* chunk, llvm::Value* size)
+{
+    if (session.isFreestanding()) {
+        const long munmap = 11;
+        createSyscall(builder, munmap,
+            { builder.CreatePtrToInt(chunk, builder.getInt64Ty()), size });
+        return;
+    }
+    llvm::FunctionType* freeType = llvm::FunctionType::get(builder.getVoidTy(),
+        { builder.getInt8PtrTy() }, false);
+    builder.CreateCall(getExternalFunction(module, "free", freeType), { chunk });
+}
 
 
-llvm::Function* qlow::gen::FunctionGenerator::generate(void)
+/*!
+ * \brief generates the slow path of region allocations, which is taken
+ *        when the current chunk is full
+ *
+ * Objects larger than a quarter of a chunk get a chunk of their own, so the
+ * rest of the current chunk is not wasted.
+ */
+static llvm::Function* generateRegionGrow(CodegenSession& session, llvm::Module* module)
 {
-    using llvm::Function;
-    using llvm::Argument;
-    using llvm::Type;
-    using llvm::FunctionType;
-    using llvm::BasicBlock;
     using llvm::Value;
-    using llvm::IRBuilder;
+    using llvm::BasicBlock;
 
-    sem::Context& semCtxt = this->method.context;
-    
-#ifdef DEBUGGING
-    printf("generate function %s\n", method.name.c_str()); 
-#endif
+    const char name[] = "_qlow_region_grow";
+    if (llvm::Function* grow = module->getFunction(name))
+        return grow;
 
-    Function* func = module->getFunction(method.getMangledName());
+    llvm::LLVMContext& context = module->getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::StructType* regionType = getRegionType(context);
+    llvm::Type* int64 = builder.getInt64Ty();
+    llvm::FunctionType* type = llvm::FunctionType::get(builder.getInt8PtrTy(),
+        { regionType->getPointerTo(), int64 }, false);
 
-    if (func == nullptr) {
-        throw "internal error: function not found";
-    }
+    llvm::Function* grow = llvm::Function::Create(type, llvm::Function::InternalLinkage, name, module);
+    grow->addFnAttr(llvm::Attribute::AttrKind::Cold);
+    grow->addFnAttr(llvm::Attribute::AttrKind::NoInline);
+    grow->addFnAttr(llvm::Attribute::AttrKind::NoUnwind);
+    grow->setReturnDoesNotAlias();
 
-    BasicBlock* bb = BasicBlock::Create(context, "entry", func);
+    BasicBlock* entry = BasicBlock::Create(context, "entry", grow);
+    BasicBlock* refill = BasicBlock::Create(context, "refill", grow);
+    BasicBlock* done = BasicBlock::Create(context, "done", grow);
+    auto argIterator = grow->arg_begin();
+    Value* region = &*argIterator++;
+    Value* size = &*argIterator;
 
-    pushBlock(bb);
+    builder.SetInsertPoint(entry);
+    Value* large = builder.CreateICmpUGT(size, builder.getInt64(regionChunkSize / 4));
+    Value* chunkSize = builder.CreateSelect(large,
+        builder.CreateAdd(size, builder.getInt64(regionChunkHeader)),
+        builder.getInt64(regionChunkSize));
+    Value* chunk = createChunkAllocation(session, module, builder, chunkSize);
 
-    IRBuilder<> builder(context);
-    builder.SetInsertPoint(bb);
-    for (auto& [name, var] : method.body->scope.getLocals()) {
-        if (var.get() == nullptr)
-            throw "wtf null variable";
-        if (var->type == nullptr)
-            throw "wtf null type";
-        
+    // link the chunk into the list of the region
+    Value* chunksRef = builder.CreateStructGEP(regionType, region, 2);
+    Value* previous = builder.CreateLoad(builder.getInt8PtrTy(), chunksRef);
+    Value* header = builder.CreateBitCast(chunk, int64->getPointerTo());
+    builder.CreateStore(builder.CreatePtrToInt(previous, int64), header);
+    builder.CreateStore(chunkSize, builder.CreateConstGEP1_64(int64, header, 1));
+    builder.CreateStore(chunk, chunksRef);
+    Value* start = builder.CreateConstGEP1_64(builder.getInt8Ty(), chunk, regionChunkHeader);
+    builder.CreateCondBr(large, done, refill);
 
-        llvm::AllocaInst* v = builder.CreateAlloca(var->type->getLlvmType(context));
-        var->allocaInst = v;
-    }
-    
-    for (auto& statement : method.body->statements) {
-#ifdef DEBUGGING
-        printf("statement visit %s\n", statement->toString().c_str());
-#endif
-        statement->accept(statementVisitor, *this);
-    }
-    
+    // continue bumping in the new chunk
+    builder.SetInsertPoint(refill);
+    builder.CreateStore(builder.CreateGEP(builder.getInt8Ty(), start, size),
+        builder.CreateStructGEP(regionType, region, 0));
+    builder.CreateStore(builder.CreateGEP(builder.getInt8Ty(), chunk, chunkSize),
+        builder.CreateStructGEP(regionType, region, 1));
+    builder.CreateBr(done);
 
-#ifdef DEBUGGING
-    printf("End of Function\n");
-#endif
-    
-    //Value* val = llvm::ConstantFP::get(context, llvm::APFloat(5.0));
-    
-    builder.SetInsertPoint(getCurrentBlock());
-    //if (method.returnType->equals(sem::NativeType(sem::NativeType::Type::VOID))) {
-    if (method.returnType == nullptr || method.returnType->isVoid()) {
-        builder.CreateRetVoid();
-    }
-    return func;
+    builder.SetInsertPoint(done);
+    builder.CreateRet(start);
+    return grow;
 }
 
 
+/*!
+ * \brief generates <code>_qlow_allocate</code>, which is called by
+ *        <code>new</code>
+ *
+ * Inside of a region, the size is rounded up to 16 bytes and taken from
+ * the current chunk. This fast path is small enough to be inlined.
+ */
+llvm::Function* generateAllocator(CodegenSession& session, llvm::Module* module)
+{
+    using llvm::Value;
+    using llvm::BasicBlock;
+
+    const char name[] = "_qlow_allocate";
+    if (llvm::Function* allocator = module->getFunction(name))
+        return allocator;
+
+    llvm::LLVMContext& context = module->getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::StructType* regionType = getRegionType(context);
+    llvm::Type* bytePtr = builder.getInt8PtrTy();
+    llvm::Type* int64 = builder.getInt64Ty();
+    llvm::FunctionType* type = llvm::FunctionType::get(bytePtr, { int64 }, false);
+
+    llvm::Function* allocator = llvm::Function::Create(type,
+        llvm::Function::InternalLinkage, name, module);
+    allocator->addFnAttr(llvm::Attribute::AttrKind::NoUnwind);
+    allocator->setReturnDoesNotAlias();
+
+    BasicBlock* entry = BasicBlock::Create(context, "entry", allocator);
+    BasicBlock* bump = BasicBlock::Create(context, "bump", allocator);
+    BasicBlock* fits = BasicBlock::Create(context, "fits", allocator);
+    BasicBlock* full = BasicBlock::Create(context, "full", allocator);
+    Value* size = &*allocator->arg_begin();
+    llvm::MDBuilder mdBuilder(context);
+
+    builder.SetInsertPoint(entry);
+    Value* region = builder.CreateLoad(regionType->getPointerTo(),
+        getCurrentRegion(session, module), "region");
+    if (session.isFreestanding()) {
+        builder.CreateBr(bump);
+    }
+    else {
+        BasicBlock* heap = BasicBlock::Create(context, "heap", allocator, bump);
+        builder.CreateCondBr(builder.CreateIsNull(region), heap, bump);
+        builder.SetInsertPoint(heap);
+        llvm::FunctionType* mallocType = llvm::FunctionType::get(bytePtr, { int64 }, false);
+        builder.CreateRet(builder.CreateCall(getExternalFunction(module, "malloc", mallocType), { size }));
+    }
+
+    builder.SetInsertPoint(bump);
+    Value* rounded = builder.CreateAnd(builder.CreateAdd(size, builder.getInt64(15)),
+        builder.getInt64(~uint64_t(15)), "rounded");
+    Value* nextRef = builder.CreateStructGEP(regionType, region, 0);
+    Value* next = builder.CreateLoad(bytePtr, nextRef, "next");
+    Value* end = builder.CreateLoad(bytePtr, builder.CreateStructGEP(regionType, region, 1), "end");
+    Value* available = builder.CreateSub(builder.CreatePtrToInt(end, int64),
+        builder.CreatePtrToInt(next, int64));
+    builder.CreateCondBr(builder.CreateICmpULE(rounded, available), fits, full,
+        mdBuilder.createBranchWeights(2000, 1));
+
+    builder.SetInsertPoint(fits);
+    builder.CreateStore(builder.CreateGEP(builder.getInt8Ty(), next, rounded), nextRef);
+    builder.CreateRet(next);
+
+    builder.SetInsertPoint(full);
+    builder.CreateRet(builder.CreateCall(generateRegionGrow(session, module), { region, rounded }));
+    return allocator;
+}
+
+
+/// generates <code>_qlow_region_free</code>, which releases all chunks of a region
+llvm::Function* generateRegionFree(CodegenSession& session, llvm::Module* module)
+{
+    using llvm::Value;
+    using llvm::BasicBlock;
+
+    const char name[] = "_qlow_region_free";
+    if (llvm::Function* free = module->getFunction(name))
+        return free;
+
+    llvm::LLVMContext& context = module->getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::StructType* regionType = getRegionType(context);
+    llvm::Type* bytePtr = builder.getInt8PtrTy();
+    llvm::Type* int64 = builder.getInt64Ty();
+    llvm::FunctionType* type = llvm::FunctionType::get(builder.getVoidTy(),
+        { regionType->getPointerTo() }, false);
+
+    llvm::Function* free = llvm::Function::Create(type, llvm::Function::InternalLinkage, name, module);
+    free->addFnAttr(llvm::Attribute::AttrKind::NoUnwind);
+
+    BasicBlock* entry = BasicBlock::Create(context, "entry", free);
+    BasicBlock* loop = BasicBlock::Create(context, "loop", free);
+    BasicBlock* exit = BasicBlock::Create(context, "exit", free);
+    Value* region = &*free->arg_begin();
+
+    builder.SetInsertPoint(entry);
+    Value* first = builder.CreateLoad(bytePtr, builder.CreateStructGEP(regionType, region, 2));
+    builder.CreateCondBr(builder.CreateIsNull(first), exit, loop);
+
+    builder.SetInsertPoint(loop);
+    llvm::PHINode* chunk = builder.CreatePHI(bytePtr, 2, "chunk");
+    chunk->addIncoming(first, entry);
+    Value* header = builder.CreateBitCast(chunk, int64->getPointerTo());
+    Value* previous = builder.CreateIntToPtr(builder.CreateLoad(int64, header), bytePtr);
+    Value* chunkSize = builder.CreateLoad(int64, builder.CreateConstGEP1_64(int64, header, 1));
+    createChunkFree(session, module, builder, chunk, chunkSize);
+    chunk->addIncoming(previous, loop);
+    builder.CreateCondBr(builder.CreateIsNull(previous), exit, loop);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateRetVoid();
+    return free;
+}
+
+
+/*!
+ * \brief generates <code>_qlow_allocate_aligned</code>, which allocates
+ *        memory aligned to more than 16 bytes
+ *
+ * Outside of regions, the memory comes from <code>aligned_alloc</code>,
+ * so that it can be deleted like any other object. In regions, the
+ * allocation is enlarged and the start rounded up.
+ */
+llvm::Function* generateAlignedAllocator(CodegenSession& session, llvm::Module* module)
+{
+    using llvm::Value;
+    using llvm::BasicBlock;
+
+    const char name[] = "_qlow_allocate_aligned";
+    if (llvm::Function* allocator = module->getFunction(name))
+        return allocator;
+
+    llvm::LLVMContext& context = module->getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::StructType* regionType = getRegionType(context);
+    llvm::Type* bytePtr = builder.getInt8PtrTy();
+    llvm::Type* int64 = builder.getInt64Ty();
+    llvm::FunctionType* type = llvm::FunctionType::get(bytePtr, { int64, int64 }, false);
+
+    llvm::Function* allocator = llvm::Function::Create(type,
+        llvm::Function::InternalLinkage, name, module);
+    allocator->addFnAttr(llvm::Attribute::AttrKind::NoUnwind);
+    allocator->setReturnDoesNotAlias();
+
+    BasicBlock* entry = BasicBlock::Create(context, "entry", allocator);
+    BasicBlock* bump = BasicBlock::Create(context, "bump", allocator);
+    Value* size = &*allocator->arg_begin();
+    Value* alignment = &*(allocator->arg_begin() + 1);
+
+    builder.SetInsertPoint(entry);
+    Value* mask = builder.CreateSub(alignment, builder.getInt64(1), "mask");
+    if (session.isFreestanding()) {
+        builder.CreateBr(bump);
+    }
+    else {
+        BasicBlock* heap = BasicBlock::Create(context, "heap", allocator, bump);
+        Value* region = builder.CreateLoad(regionType->getPointerTo(),
+            getCurrentRegion(session, module), "region");
+        builder.CreateCondBr(builder.CreateIsNull(region), heap, bump);
+
+        // aligned_alloc needs a multiple of the alignment as size
+        builder.SetInsertPoint(heap);
+        Value* rounded = builder.CreateAnd(builder.CreateAdd(size, mask),
+            builder.CreateNot(mask), "rounded");
+        llvm::FunctionType* alignedAllocType = llvm::FunctionType::get(bytePtr, { int64, int64 }, false);
+        builder.CreateRet(builder.CreateCall(getExternalFunction(module, "aligned_alloc", alignedAllocType),
+            { alignment, rounded }));
+    }
+
+    builder.SetInsertPoint(bump);
+    Value* enlarged = builder.CreateAdd(size, builder.CreateSub(alignment, builder.getInt64(16)));
+    Value* memory = builder.CreateCall(generateAllocator(session, module), { enlarged });
+    Value* address = builder.CreatePtrToInt(memory, int64);
+    Value* aligned = builder.CreateAnd(builder.CreateAdd(address, mask), builder.CreateNot(mask));
+    builder.CreateRet(builder.CreateGEP(builder.getInt8Ty(), memory,
+        builder.CreateSub(aligned, address)));
+    return allocator;
+}
+
+
+/*!
+ * \brief generates <code>_qlow_deallocate</code>, which is called by
+ *        <code>delete</code>
+ *
+ * Inside of regions, the chunks of the current and all enclosing regions
+ * are searched for the object. Objects of a region are only reclaimed
+ * together with it, all others are freed.
+ */
+llvm::Function* generateDeallocator(CodegenSession& session, llvm::Module* module)
+{
+    using llvm::Value;
+    using llvm::BasicBlock;
+
+    const char name[] = "_qlow_deallocate";
+    if (llvm::Function* deallocator = module->getFunction(name))
+        return deallocator;
+
+    llvm::LLVMContext& context = module->getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::StructType* regionType = getRegionType(context);
+    llvm::Type* bytePtr = builder.getInt8PtrTy();
+    llvm::Type* int64 = builder.getInt64Ty();
+    llvm::FunctionType* type = llvm::FunctionType::get(builder.getVoidTy(),
+        { bytePtr }, false);
+
+    llvm::Function* deallocator = llvm::Function::Create(type,
+        llvm::Function::InternalLinkage, name, module);
+    deallocator->addFnAttr(llvm::Attribute::AttrKind::NoUnwind);
+
+    BasicBlock* entry = BasicBlock::Create(context, "entry", deallocator);
+    BasicBlock* regionLoop = BasicBlock::Create(context, "region", deallocator);
+    BasicBlock* chunkLoop = BasicBlock::Create(context, "chunk", deallocator);
+    BasicBlock* checkChunk = BasicBlock::Create(context, "checkchunk", deallocator);
+    BasicBlock* nextChunk = BasicBlock::Create(context, "nextchunk", deallocator);
+    BasicBlock* nextRegion = BasicBlock::Create(context, "nextregion", deallocator);
+    BasicBlock* heap = BasicBlock::Create(context, "heap", deallocator);
+    BasicBlock* exit = BasicBlock::Create(context, "exit", deallocator);
+    Value* object = &*deallocator->arg_begin();
+
+    builder.SetInsertPoint(entry);
+    Value* address = builder.CreatePtrToInt(object, int64);
+    Value* current = builder.CreateLoad(regionType->getPointerTo(),
+        getCurrentRegion(session, module), "region");
+    builder.CreateCondBr(builder.CreateIsNull(current), heap, regionLoop);
+
+    builder.SetInsertPoint(regionLoop);
+    llvm::PHINode* region = builder.CreatePHI(regionType->getPointerTo(), 2, "region");
+    region->addIncoming(current, entry);
+    Value* first = builder.CreateLoad(bytePtr, builder.CreateStructGEP(regionType, region, 2));
+    builder.CreateBr(chunkLoop);
+
+    builder.SetInsertPoint(chunkLoop);
+    llvm::PHINode* chunk = builder.CreatePHI(bytePtr, 2, "chunk");
+    chunk->addIncoming(first, regionLoop);
+    builder.CreateCondBr(builder.CreateIsNull(chunk), nextRegion, checkChunk);
+
+    // the size in the header includes the header itself
+    builder.SetInsertPoint(checkChunk);
+    Value* header = builder.CreateBitCast(chunk, int64->getPointerTo());
+    Value* chunkSize = builder.CreateLoad(int64, builder.CreateConstGEP1_64(int64, header, 1));
+    Value* offset = builder.CreateSub(address, builder.CreatePtrToInt(chunk, int64));
+    builder.CreateCondBr(builder.CreateICmpULT(offset, chunkSize), exit, nextChunk);
+
+    builder.SetInsertPoint(nextChunk);
+    chunk->addIncoming(builder.CreateIntToPtr(builder.CreateLoad(int64, header), bytePtr), nextChunk);
+    builder.CreateBr(chunkLoop);
+
+    builder.SetInsertPoint(nextRegion);
+    Value* outer = builder.CreateBitCast(
+        builder.CreateLoad(bytePtr, builder.CreateStructGEP(regionType, region, 3)),
+        regionType->getPointerTo());
+    region->addIncoming(outer, nextRegion);
+    builder.CreateCondBr(builder.CreateIsNull(outer), heap, regionLoop);
+
+    builder.SetInsertPoint(heap);
+    llvm::FunctionType* freeType = llvm::FunctionType::get(builder.getVoidTy(),
+        { builder.getInt8PtrTy() }, false);
+    builder.CreateCall(getExternalFunction(module, "free", freeType), { object });
+    builder.CreateBr(exit);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateRetVoid();
+    return deallocator;
+}
+
+
+/*!
+ * \brief defines a byte by byte <code>memcpy</code> or <code>memset</code>
+ *
+ * The backend lowers large copies and initializations to calls of these,
+ * so freestanding modules have to define them. They are weak, so that
+ * a C library linked in with them takes precedence.
+ */
+static void generateMemoryFunction(llvm::Module* module, const std::string& name, bool copy)
+{
+    using llvm::Value;
+    using llvm::BasicBlock;
+
+    if (module->getFunction(name) != nullptr)
+        return;
+
+    llvm::LLVMContext& context = module->getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::Type* byte = builder.getInt8Ty();
+    llvm::Type* int64 = builder.getInt64Ty();
+    llvm::Type* pointer = builder.getInt8PtrTy();
+    llvm::Type* sourceType = copy ? pointer : builder.getInt32Ty();
+    llvm::FunctionType* type = llvm::FunctionType::get(pointer,
+        { pointer, sourceType, int64 }, false);
+
+    llvm::Function* function = llvm::Function::Create(type,
+        llvm::Function::WeakAnyLinkage, name, module);
+    function->setVisibility(llvm::GlobalValue::HiddenVisibility);
+    function->addFnAttr(llvm::Attribute::AttrKind::NoUnwind);
+    // the loop must not be recognized as a call to the function itself
+    function->addFnAttr("no-builtins");
+
+    BasicBlock* entry = BasicBlock::Create(context, "entry", function);
+    BasicBlock* loop = BasicBlock::Create(context, "loop", function);
+    BasicBlock* exit = BasicBlock::Create(context, "exit", function);
+    auto argIterator = function->arg_begin();
+    Value* destination = &*argIterator++;
+    Value* source = &*argIterator++;
+    Value* size = &*argIterator;
+
+    builder.SetInsertPoint(entry);
+    builder.CreateCondBr(builder.CreateICmpEQ(size, builder.getInt64(0)), exit, loop);
+
+    builder.SetInsertPoint(loop);
+    llvm::PHINode* i = builder.CreatePHI(int64, 2, "i");
+    i->addIncoming(builder.getInt64(0), entry);
+    Value* value = copy ?
+        builder.CreateLoad(byte, builder.CreateGEP(byte, source, i)) :
+        builder.CreateTrunc(source, byte);
+    builder.CreateStore(value, builder.CreateGEP(byte, destination, i));
+    Value* next = builder.CreateAdd(i, builder.getInt64(1), "", true, true);
+    i->addIncoming(next, loop);
+    builder.CreateCondBr(builder.CreateICmpEQ(next, size), exit, loop);
+
+    builder.SetInsertPoint(exit);
+    builder.CreateRet(destination);
+}
+
+
+void generateRuntimeFunctions(llvm::Module* module)
+{
+    generateMemoryFunction(module, "memcpy", true);
+    generateMemoryFunction(module, "memset", false);
+}
+
+
+/// returns true if \p method deletes objects or declares owned variables
+static bool freesMemory(sem::Method& method)
+{
+    if (!method.body)
+        return false;
+    bool frees = false;
+    sem::forEachStatement(*method.body, [&frees] (sem::Statement& statement) {
+        if (dynamic_cast<sem::DeleteStatement*>(&statement) != nullptr)
+            frees = true;
+        else if (auto* block = dynamic_cast<sem::DoEndBlock*>(&statement)) {
+            for (auto& [name, variable] : block->scope.getLocals()) {
+                if (variable->isOwned)
+                    frees = true;
+            }
+        }
+    });
+    return frees;
+}
+
+
+bool needsCLibrary(const Options& options, sem::GlobalScope& objects)
+{
+    // libraries given with -l are assumed to be C libraries
+    if (options.profileGenerate || !options.libs.empty())
+        return true;
+
+    // new does not need malloc, as freestanding modules allocate from a
+    // region that is never freed outside of region blocks. Single objects
+    // can not be given back to it, so delete and owned variables need free.
+    //
+    // the ifuncs of @target_clones are resolved through IRELATIVE
+    // relocations, which only the static startup code of libc applies
+    for (const auto& [name, method] : objects.getMethods()) {
+        if (method->isExtern || !method->targetClones.empty() || freesMemory(*method))
+            return true;
+    }
+    for (const auto& [name, cl] : objects.getClasses()) {
+        for (const auto& [name, method] : cl->methods) {
+            if (!method->targetClones.empty() || freesMemory(*method))
+                return true;
+        }
+    }
+    return false;
+}
+
+
+#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 14
+using OptimizationLevel = llvm::OptimizationLevel;
+#else
+using OptimizationLevel = llvm::PassBuilder::OptimizationLevel;
+#endif
+
+
+static OptimizationLevel getOptimizationLevel(const Options& options)
+{
+    if (options.sizeLevel == 1)
+        return OptimizationLevel::Os;
+    if (options.sizeLevel == 2)
+        return OptimizationLevel::Oz;
+    switch (options.optLevel) {
+    case 0:
+        return OptimizationLevel::O0;
+    case 1:
+        return OptimizationLevel::O1;
+    case 2:
+        return OptimizationLevel::O2;
+    default:
+        return OptimizationLevel::O3;
+    }
+}
+
+
+/*!
+ * \brief gives all methods internal linkage
+ *
+ * A program is compiled into a single module and only entered through
+ * its entry point. Internal methods are called without going through the
+ * PLT, can be removed once they are inlined everywhere, and their
+ * signatures can be changed by the interprocedural passes.
+ *
+ * The pass is called <code>qlow-internalize</code> in textual pipelines.
+ */
+struct InternalizeMethodsPass : public llvm::PassInfoMixin<InternalizeMethodsPass>
+{
+    llvm::PreservedAnalyses run(llvm::Module& module, llvm::ModuleAnalysisManager&)
+    {
+        bool changed = false;
+        for (llvm::Function& function : module) {
+            if (function.isDeclaration() || !function.hasExternalLinkage() ||
+                !qlow::isMangledName(function.getName().str()))
+                continue;
+            function.setLinkage(llvm::GlobalValue::InternalLinkage);
+            changed = true;
+        }
+        return changed ? llvm::PreservedAnalyses::none() : llvm::PreservedAnalyses::all();
+    }
+};
+
+
+/*!
+ * \brief parses the pipelines given with <code>--passes-ep-&lt;point&gt;</code>
+ *        and inserts them at the respective extension points
+ *
+ * This is also where passes specific to qlow are added to the pipeline.
+ */
+static void registerExtensionPoints(llvm::PassBuilder& passBuilder, const Options& options)
+{
+    using llvm::FunctionPassManager;
+    using llvm::ModulePassManager;
+
+    if (auto* instrumentation = passBuilder.getPassInstrumentationCallbacks())
+        instrumentation->addClassToPassName(InternalizeMethodsPass::name(), "qlow-internalize");
+    passBuilder.registerPipelineParsingCallback(
+        [] (llvm::StringRef name, ModulePassManager& mpm, llvm::ArrayRef<llvm::PassBuilder::PipelineElement>) {
+            if (name != "qlow-internalize")
+                return false;
+            mpm.addPass(InternalizeMethodsPass());
+            return true;
+        });
+    // unoptimized builds keep all methods visible for debugging
+    passBuilder.registerPipelineStartEPCallback(
+        [] (ModulePassManager& mpm, OptimizationLevel level) {
+            if (level != OptimizationLevel::O0)
+                mpm.addPass(InternalizeMethodsPass());
+        });
+
+    auto parse = [&passBuilder] (auto& passManager, const std::string& pipeline) {
+        if (auto error = passBuilder.parsePassPipeline(passManager, pipeline)) {
+            printError(Printer::getInstance(), llvm::toString(std::move(error)));
+            throw "invalid pass pipeline";
+        }
+    };
+
+    for (const auto& [point, pipeline] : options.extensionPipelines) {
+        const std::string& p = pipeline;
+        if (point == "peephole") {
+            passBuilder.registerPeepholeEPCallback(
+                [parse, p] (FunctionPassManager& fpm, OptimizationLevel) { parse(fpm, p); });
+        }
+        else if (point == "scalar-optimizer-late") {
+            passBuilder.registerScalarOptimizerLateEPCallback(
+                [parse, p] (FunctionPassManager& fpm, OptimizationLevel) { parse(fpm, p); });
+        }
+        else if (point == "vectorizer-start") {
+            passBuilder.registerVectorizerStartEPCallback(
+                [parse, p] (FunctionPassManager& fpm, OptimizationLevel) { parse(fpm, p); });
+        }
+        else if (point == "pipeline-start") {
+            passBuilder.registerPipelineStartEPCallback(
+                [parse, p] (ModulePassManager& mpm, OptimizationLevel) { parse(mpm, p); });
+        }
+        else if (point == "optimizer-last") {
+            passBuilder.registerOptimizerLastEPCallback(
+                [parse, p] (ModulePassManager& mpm, OptimizationLevel) { parse(mpm, p); });
+        }
+        else {
+            printError(Printer::getInstance(), "unknown extension point '" + point + "'");
+            throw "invalid pass pipeline";
+        }
+    }
+}
+
+
+/*!
+ * \brief returns the profile guided optimization settings of the options
+ *
+ * With <code>-fprofile-generate</code>, counters are inserted after the
+ * early inlining, so that the profile can be used again on a build at the
+ * same optimization level.
+ */
+static llvm::Optional<llvm::PGOOptions> getPgoOptions(const Options& options)
+{
+    if (options.profileGenerate && !options.profileUse.empty())
+        throw "-fprofile-generate and -fprofile-use cannot be combined";
+
+    if (options.profileGenerate) {
+        // an empty file name selects default.profraw, which can be
+        // overridden at runtime with the LLVM_PROFILE_FILE variable
+        return llvm::PGOOptions("", "", "", llvm::PGOOptions::IRInstr);
+    }
+    if (!options.profileUse.empty()) {
+        if (!llvm::sys::fs::exists(options.profileUse))
+            throw "profile given with -fprofile-use does not exist";
+        return llvm::PGOOptions(options.profileUse, "", "", llvm::PGOOptions::IRUse);
+    }
+    return llvm::None;
+}
+
+
+/*!
+ * \brief runs the optimization pipeline selected by the options
+ *
+ * Uses the default pipeline of the new pass manager for the optimization
+ * level, or the pipeline given with <code>--passes</code>. Profile
+ * instrumentation and profile use are part of the default pipelines only.
+ */
+static void optimizeModule(llvm::Module& module, llvm::TargetMachine* targetMachine,
+    const Options& options)
+{
+    OptimizationLevel level = getOptimizationLevel(options);
+
+    // with -fno-inline, only functions marked @always_inline are inlined
+    if (options.noInline) {
+        for (llvm::Function& function : module) {
+            if (!function.isDeclaration() &&
+                !function.hasFnAttribute(llvm::Attribute::AttrKind::AlwaysInline))
+                function.addFnAttr(llvm::Attribute::AttrKind::NoInline);
+        }
+    }
+
+    llvm::PipelineTuningOptions tuning;
+    tuning.LoopUnrolling = options.optLevel >= 2 && options.sizeLevel == 0;
+    tuning.LoopVectorization = options.optLevel >= 2 && options.sizeLevel < 2;
+    tuning.SLPVectorization = options.optLevel >= 2 && options.sizeLevel < 2;
+
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
+
+    // maps pass classes to their names in textual pipelines
+    llvm::PassInstrumentationCallbacks instrumentation;
+    llvm::PassBuilder passBuilder(targetMachine, tuning, getPgoOptions(options), &instrumentation);
+    registerExtensionPoints(passBuilder, options);
+
+    passBuilder.registerModuleAnalyses(mam);
+    passBuilder.registerCGSCCAnalyses(cgam);
+    passBuilder.registerFunctionAnalyses(fam);
+    passBuilder.registerLoopAnalyses(lam);
+    passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+    llvm::ModulePassManager mpm;
+    if (!options.passes.empty()) {
+        if (auto error = passBuilder.parsePassPipeline(mpm, options.passes)) {
+            printError(Printer::getInstance(), llvm::toString(std::move(error)));
+            throw "invalid pass pipeline";
+        }
+    }
+    else if (level == OptimizationLevel::O0) {
+        mpm = passBuilder.buildO0DefaultPipeline(level, options.lto != Options::Lto::NONE);
+    }
+    else if (options.lto == Options::Lto::THIN) {
+        mpm = passBuilder.buildThinLTOPreLinkDefaultPipeline(level);
+    }
+    else if (options.lto == Options::Lto::FULL) {
+        mpm = passBuilder.buildLTOPreLinkDefaultPipeline(level);
+    }
+    else {
+        mpm = passBuilder.buildPerModuleDefaultPipeline(level);
+    }
+
+    if (options.printPipeline) {
+        std::string pipeline;
+        llvm::raw_string_ostream pipelineStream(pipeline);
+        mpm.printPipeline(pipelineStream, [&instrumentation] (llvm::StringRef className) {
+            llvm::StringRef passName = instrumentation.getPassNameForClassName(className);
+            return passName.empty() ? className : passName;
+        });
+        Printer::getInstance() << pipelineStream.str() << std::endl;
+    }
+
+    mpm.run(module, mam);
+}
+
+
+/*!
+ * \brief prints the optimization remarks selected with <code>-Rpass</code>,
+ *        <code>-Rpass-missed</code> and <code>-Rpass-analysis</code>
+ *
+ * Other diagnostics are left to the default handler of llvm.
+ */
+class RemarkPrinter : public llvm::DiagnosticHandler
+{
+    std::unique_ptr<llvm::Regex> passed;
+    std::unique_ptr<llvm::Regex> missed;
+    std::unique_ptr<llvm::Regex> analysis;
+
+    static std::unique_ptr<llvm::Regex> createFilter(const std::string& pattern)
+    {
+        if (pattern.empty())
+            return nullptr;
+        auto regex = std::make_unique<llvm::Regex>(pattern);
+        std::string error;
+        if (!regex->isValid(error)) {
+            printError(Printer::getInstance(), "'" + pattern + "': " + error);
+            throw "invalid regular expression for optimization remarks";
+        }
+        return regex;
+    }
+
+    static bool matches(const std::unique_ptr<llvm::Regex>& filter, llvm::StringRef passName)
+    {
+        return filter != nullptr && filter->match(passName);
+    }
+public:
+    inline RemarkPrinter(const Options& options) :
+        passed{ createFilter(options.passRemarks) },
+        missed{ createFilter(options.missedRemarks) },
+        analysis{ createFilter(options.analysisRemarks) }
+    {
+    }
+
+    bool isPassedOptRemarkEnabled(llvm::StringRef passName) const override
+    {
+        return matches(passed, passName);
+    }
+
+    bool isMissedOptRemarkEnabled(llvm::StringRef passName) const override
+    {
+        return matches(missed, passName);
+    }
+
+    bool isAnalysisRemarkEnabled(llvm::StringRef passName) const override
+    {
+        return matches(analysis, passName);
+    }
+
+    bool isAnyRemarkEnabled(void) const override
+    {
+        return passed != nullptr || missed != nullptr || analysis != nullptr;
+    }
+
+    bool handleDiagnostics(const llvm::DiagnosticInfo& info) override
+    {
+        auto* remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&info);
+        if (remark == nullptr)
+            return false;
+        if (!remark->isEnabled())
+            return true;
+
+        std::string option = "-Rpass-analysis";
+        if (llvm::isa<llvm::OptimizationRemark>(remark) ||
+            llvm::isa<llvm::MachineOptimizationRemark>(remark))
+            option = "-Rpass";
+        else if (llvm::isa<llvm::OptimizationRemarkMissed>(remark) ||
+            llvm::isa<llvm::MachineOptimizationRemarkMissed>(remark))
+            option = "-Rpass-missed";
+
+        // the locations come from the debug information, which is created
+        // from the code positions
+        CodePosition pos = CodePosition::none();
+        if (remark->isLocationAvailable()) {
+            llvm::DiagnosticLocation location = remark->getLocation();
+            int line = static_cast<int>(location.getLine());
+            int column = static_cast<int>(location.getColumn());
+            pos = CodePosition{ location.getAbsolutePath(), line, line, column, column };
+        }
+        printRemark(Printer::getInstance(),
+            remark->getMsg() + " [" + option + "=" + remark->getPassName().str() + "]", pos);
+        return true;
+    }
+};
+
+
+/// writes the textual llvm ir of \p module to \p filename
+static void writeIr(const llvm::Module& module, const std::string& filename)
+{
+    std::error_code errorCode;
+    llvm::raw_fd_ostream out(filename, errorCode, llvm::sys::fs::OF_Text);
+    if (errorCode)
+        throw "could not open the output file";
+    module.print(out, nullptr);
+}
+
+
+/// closes the optimization record and detaches it from the context
+static void finishRemarks(llvm::LLVMContext& context, std::unique_ptr<llvm::ToolOutputFile> file)
+{
+    if (file == nullptr)
+        return;
+    file->keep();
+    context.setLLVMRemarkStreamer(nullptr);
+    context.setMainRemarkStreamer(nullptr);
+}
+
+
+void generateObjectFile(const std::string& filename, std::unique_ptr<llvm::Module> module, const Options& options)
+{
+    using llvm::legacy::PassManager;
+    using llvm::raw_fd_ostream;
+    using llvm::TargetMachine;
+
+    Printer& printer = Printer::getInstance();
+#ifdef DEBUGGING
+    printer << "verifying mod" << std::endl;
+#endif
+    auto ostr = llvm::raw_os_ostream(printer);
+#ifdef DEBUGGING
+    module->print(ostr, nullptr);
+#endif
+    bool broken = llvm::verifyModule(*module);
+    
+    if (broken)
+        throw "invalid llvm module";
+    
+    std::unique_ptr<TargetMachine> targetMachine = createTargetMachine(options);
+
+    module->setTargetTriple(targetMachine->getTargetTriple().str());
+    module->setDataLayout(targetMachine->createDataLayout());
+
+    if (options.emitLlvm) {
+        llvm::SmallString<128> unoptimized(filename);
+        llvm::sys::path::replace_extension(unoptimized, "unoptimized.ll");
+        writeIr(*module, unoptimized.str().str());
+    }
+
+    // remarks are reported for the optimizations and the backend
+    llvm::LLVMContext& context = module->getContext();
+    context.setDiagnosticHandler(std::make_unique<RemarkPrinter>(options));
+    std::unique_ptr<llvm::ToolOutputFile> remarksFile;
+    if (options.saveOptimizationRecord) {
+        llvm::SmallString<128> remarksPath(options.outfile);
+        llvm::sys::path::replace_extension(remarksPath, "opt.yaml");
+        auto file = llvm::setupLLVMOptimizationRemarks(context, remarksPath, "", "yaml", false);
+        if (!file) {
+            printError(printer, llvm::toString(file.takeError()));
+            throw "could not create the optimization record";
+        }
+        remarksFile = std::move(*file);
+    }
+
+    optimizeModule(*module, targetMachine.get(), options);
+
+    if (options.emitLlvm) {
+        writeIr(*module, filename);
+        finishRemarks(context, std::move(remarksFile));
+        return;
+    }
+
+    std::error_code errorCode;
+
+    raw_fd_ostream dest(filename, errorCode, llvm::sys::fs::F_None);
+    if (errorCode)
+        throw "could not open the output file";
+
+    // with lto, code generation is left to the linker
+    if (options.lto != Options::Lto::NONE && !options.emitAssembly) {
+        if (options.lto == Options::Lto::THIN) {
+            llvm::ProfileSummaryInfo profileSummary(*module);
+            llvm::ModuleSummaryIndex summary =
+                llvm::buildModuleSummaryIndex(*module, nullptr, &profileSummary);
+            llvm::WriteBitcodeToFile(*module, dest, false, &summary, true);
+        }
+        else {
+            llvm::WriteBitcodeToFile(*module, dest);
+        }
+        dest.flush();
+        dest.close();
+        finishRemarks(context, std::move(remarksFile));
+        return;
+    }
+
+    // the backend still runs on the legacy pass manager
+    PassManager pm;
+#ifdef DEBUGGING
+    printer << "adding passes" << std::endl;
+#endif
+    targetMachine->addPassesToEmitFile(pm, dest,
+//        llvm::LLVMTargetMachine::CGFT_ObjectFile,
+#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 7
+            nullptr,
+#endif
+//        nullptr,
+        options.emitAssembly ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile);
+
+    pm.run(*module);
+    dest.flush();
+    dest.close();
+    finishRemarks(context, std::move(remarksFile));
+
+    return;
+}
+
+} // namespace gen
+} // namespace qlow
+
+
+llvm::Type* qlow::gen::CodegenSession::getLlvmType(const sem::Type* type)
+{
+    if (auto t = types.find(type); t != types.end())
+        return t->second;
+
+    llvm::Type* llvmType = type->createLlvmTypeDecl(llvmContext);
+    if (type->isNativeType()) {
+        types[type] = llvmType;
+        return llvmType;
+    }
+
+    // structs are registered before their body is lowered, so that
+    // reference types can contain pointers to themselves
+    // TODO implement detection of circles in value types
+    auto* structType = llvm::cast<llvm::StructType>(llvmType);
+    if (type->isReferenceType())
+        types[type] = structType->getPointerTo();
+    else
+        types[type] = structType;
+
+    std::vector<llvm::Type*> structTypes;
+    if (type->isClassType()) {
+        lowerClassFields(type->getClass(), structTypes);
+        structType->setBody(structTypes, type->getClass()->packed);
+        unsigned alignment = computeAlignment(type->getClass());
+        if (alignment != dataLayout.getABITypeAlign(structType).value())
+            alignments[type] = alignment;
+    }
+    else if (type->isSoaArrayType()) {
+        // the columns share one allocation, see getSoaLayout
+        structTypes = {
+            llvm::Type::getInt8PtrTy(llvmContext),              // columns pointer
+            llvm::Type::getInt64Ty(llvmContext)                 // length
+        };
+        structType->setBody(structTypes);
+    }
+    else if (type->isArrayType()) {
+        structTypes = {
+            getLlvmType(type->getArrayOf())->getPointerTo(),    // elements pointer
+            llvm::Type::getInt64Ty(llvmContext)                 // length
+        };
+        structType->setBody(structTypes);
+    }
+
+    return types[type];
+}
+
+
+unsigned qlow::gen::CodegenSession::getAlignment(const sem::Type* type)
+{
+    llvm::Type* llvmType = getLlvmType(type);
+    if (type->isClassType() && !type->isReferenceType())
+        return getStructAlignment(type);
+    return dataLayout.getABITypeAlign(llvmType).value();
+}
+
+
+unsigned qlow::gen::CodegenSession::getStructAlignment(const sem::Type* type)
+{
+    llvm::Type* llvmType = getLlvmType(type);
+    if (auto alignment = alignments.find(type); alignment != alignments.end())
+        return alignment->second;
+    if (type->isReferenceType())
+        llvmType = llvmType->getPointerElementType();
+    return dataLayout.getABITypeAlign(llvmType).value();
+}
+
+
+unsigned qlow::gen::CodegenSession::computeAlignment(const sem::Class* semClass)
+{
+    unsigned alignment = std::max(semClass->alignment, 1u);
+    if (!semClass->packed) {
+        for (auto* field : semClass->fieldOrder)
+            alignment = std::max(alignment, getAlignment(field->type));
+    }
+    return alignment;
+}
+
+
+/*!
+ * Fields are placed in declaration order, or by decreasing alignment with
+ * <code>--field-layout=optimized</code>, which needs no padding between
+ * fields of power of two sizes. Where a field or the end of the struct
+ * must be aligned further than llvm would do by itself, the padding is
+ * inserted as an explicit byte array.
+ */
+void qlow::gen::CodegenSession::lowerClassFields(const sem::Class* semClass,
+    std::vector<llvm::Type*>& structTypes)
+{
+    std::vector<sem::Field*> fields = semClass->fieldOrder;
+    if (options.fieldLayout == Options::FieldLayout::OPTIMIZED && !semClass->packed) {
+        std::stable_sort(fields.begin(), fields.end(), [this] (sem::Field* a, sem::Field* b) {
+            return getAlignment(a->type) > getAlignment(b->type);
+        });
+    }
+
+    auto addPadding = [&] (uint64_t bytes) {
+        structTypes.push_back(llvm::ArrayType::get(llvm::Type::getInt8Ty(llvmContext), bytes));
+    };
+
+    uint64_t offset = 0;
+    for (sem::Field* field : fields) {
+        llvm::Type* fieldType = getLlvmType(field->type);
+        if (!semClass->packed) {
+            uint64_t aligned = llvm::alignTo(offset, getAlignment(field->type));
+            uint64_t natural = llvm::alignTo(offset, dataLayout.getABITypeAlign(fieldType).value());
+            if (aligned != natural)
+                addPadding(aligned - offset);
+            offset = aligned;
+        }
+        structTypes.push_back(fieldType);
+        structIndices[field] = structTypes.size() - 1;
+        offset += dataLayout.getTypeAllocSize(fieldType);
+    }
+
+    // the size must be a multiple of the alignment, so that the elements
+    // of arrays are aligned as well
+    uint64_t size = llvm::alignTo(offset, computeAlignment(semClass));
+    uint64_t natural = offset;
+    if (!semClass->packed) {
+        unsigned maxAlignment = 1;
+        for (llvm::Type* t : structTypes)
+            maxAlignment = std::max<unsigned>(maxAlignment, dataLayout.getABITypeAlign(t).value());
+        natural = llvm::alignTo(offset, maxAlignment);
+    }
+    if (size != natural)
+        addPadding(size - offset);
+}
+
+
+llvm::FastMathFlags qlow::gen::CodegenSession::getFastMathFlags(void) const
+{
+    llvm::FastMathFlags flags;
+    if (options.fastMath) {
+        flags.setFast();
+        return flags;
+    }
+    flags.setAllowReassoc(options.associativeMath);
+    flags.setAllowReciprocal(options.reciprocalMath);
+    flags.setNoNaNs(options.finiteMath);
+    flags.setNoInfs(options.finiteMath);
+    flags.setNoSignedZeros(options.noSignedZeros);
+    flags.setAllowContract(options.fpContract);
+    return flags;
+}
+
+
+unsigned qlow::gen::CodegenSession::getStructIndex(const sem::Field* field) const
+{
+    if (auto index = structIndices.find(field); index != structIndices.end())
+        return index->second;
+    throw "internal error: field of unlowered struct accessed";
+}
+
+
+qlow::gen::CodegenSession::SoaLayout qlow::gen::CodegenSession::getSoaLayout(const sem::Type* structType)
+{
+    std::vector<sem::Field*> fields = structType->getClass()->fieldOrder;
+    std::stable_sort(fields.begin(), fields.end(), [this] (sem::Field* a, sem::Field* b) {
+        return getAlignment(a->type) > getAlignment(b->type);
+    });
+
+    // the size of a type is a multiple of its alignment, so each column
+    // ends aligned for the next one
+    SoaLayout layout{ {}, 0, 1 };
+    for (sem::Field* field : fields) {
+        layout.columns.push_back({ field, layout.elementSize });
+        layout.elementSize += dataLayout.getTypeAllocSize(getLlvmType(field->type));
+    }
+    if (!fields.empty())
+        layout.alignment = getAlignment(fields.front()->type);
+    return layout;
+}
+
+
+bool qlow::gen::CodegenSession::isPassedInMemory(const sem::Type* type, const llvm::DataLayout& layout)
+{
+    // same limit as for aggregates in the System V x86-64 ABI
+    const uint64_t maxRegisterSize = 16;
+    return type->isStructType() &&
+        layout.getTypeAllocSize(getLlvmType(type)) > maxRegisterSize;
+}
+
+
+llvm::Function* qlow::gen::CodegenSession::getFunction(const sem::Method* method) const
+{
+    if (auto function = functions.find(method); function != functions.end())
+        return function->second;
+    throw "internal error: function not found";
+}
+
+
+void qlow::gen::CodegenSession::setFunction(const sem::Method* method, llvm::Function* function)
+{
+    functions[method] = function;
+}
+
+
+llvm::Value* qlow::gen::CodegenSession::getVariable(const sem::Variable* variable) const
+{
+    if (auto value = variables.find(variable); value != variables.end())
+        return value->second;
+    throw "internal error: variable without llvm value";
+}
+
+
+void qlow::gen::CodegenSession::setVariable(const sem::Variable* variable, llvm::Value* value)
+{
+    variables[variable] = value;
+}
+
+
+/// returns the variables of all blocks in \p body, which all live until
+/// the function returns
+static std::vector<sem::Variable*> getLocalVariables(sem::DoEndBlock& body)
+{
+    std::vector<sem::Variable*> variables;
+    sem::forEachStatement(body, [&variables] (sem::Statement& statement) {
+        sem::LocalScope* scope = nullptr;
+        if (auto* block = dynamic_cast<sem::DoEndBlock*>(&statement))
+            scope = &block->scope;
+        else if (auto* loop = dynamic_cast<sem::ForBlock*>(&statement))
+            scope = &loop->scope;
+
+        if (scope != nullptr) {
+            for (auto& [name, var] : scope->getLocals())
+                variables.push_back(var.get());
+        }
+    });
+    return variables;
+}
+
+
+llvm::Function* qlow::gen::FunctionGenerator::generate(void)
+{
+    using llvm::Function;
+    using llvm::Argument;
+    using llvm::Type;
+    using llvm::FunctionType;
+    using llvm::BasicBlock;
+    using llvm::Value;
+    using llvm::IRBuilder;
+
+    sem::Context& semCtxt = this->method.context;
+    llvm::LLVMContext& context = getContext();
+    
+#ifdef DEBUGGING
+    printf("generate function %s\n", method.name.c_str()); 
+#endif
+
+    Function* func = module->getFunction(method.getMangledName());
+
+    if (func == nullptr) {
+        throw "internal error: function not found";
+    }
+
+    BasicBlock* bb = BasicBlock::Create(context, "entry", func);
+
+    pushBlock(bb);
+
+    IRBuilder<> builder(context);
+    builder.SetInsertPoint(bb);
+    for (auto* var : getLocalVariables(*method.body)) {
+        if (var == nullptr)
+            throw "wtf null variable";
+        if (var->type == nullptr)
+            throw "wtf null type";
+        
+
+        llvm::AllocaInst* v = builder.CreateAlloca(session.getLlvmType(var->type));
+        alignAlloca(v, var->type);
+        session.setVariable(var, v);
+    }
+
+    if (func->hasStructRetAttr())
+        returnSlot = &*func->arg_begin();
+
+    // struct arguments passed in registers are stored on the stack, so
+    // that their fields can be addressed. SROA promotes them again. Array
+    // arguments are stored as well, as arrays are used through a pointer
+    // to their { elements, length } struct like local arrays.
+    for (auto* arg : method.arguments) {
+        llvm::Value* value = session.getVariable(arg);
+        if ((arg->type->isStructType() || arg->type->isArrayType()) &&
+            !value->getType()->isPointerTy()) {
+            llvm::AllocaInst* v = builder.CreateAlloca(value->getType());
+            alignAlloca(v, arg->type);
+            builder.CreateStore(value, v);
+            session.setVariable(arg, v);
+        }
+        // self-recursive calls in tail position jump back with new arguments
+        else if (method.isTailRecursive) {
+            llvm::AllocaInst* v = builder.CreateAlloca(value->getType());
+            builder.CreateStore(value, v);
+            session.setVariable(arg, v);
+        }
+    }
+
+    if (debugInfo != nullptr) {
+        subprogram = debugInfo->createSubprogram(method, func);
+        generateVariableDescriptions(bb);
+    }
+
+    if (method.isTailRecursive) {
+        tailRecursionBlock = BasicBlock::Create(context, "tailrecurse", func);
+        builder.CreateBr(tailRecursionBlock);
+        setCurrentBlock(tailRecursionBlock);
+    }
+    
+    for (auto& statement : method.body->statements) {
+#ifdef DEBUGGING
+        printf("statement visit %s\n", statement->toString().c_str());
+#endif
+        statement->accept(statementVisitor, *this);
+    }
+    
+
+#ifdef DEBUGGING
+    printf("End of Function\n");
+#endif
+    
+    //Value* val = llvm::ConstantFP::get(context, llvm::APFloat(5.0));
+    
+    builder.SetInsertPoint(getCurrentBlock());
+    //if (method.returnType->equals(sem::NativeType(sem::NativeType::Type::VOID))) {
+    if ((method.returnType == nullptr || method.returnType->isVoid()) &&
+        !getCurrentBlock()->getTerminator()) {
+        builder.CreateRetVoid();
+    }
+
+    if (debugInfo != nullptr)
+        debugInfo->finalizeSubprogram(subprogram);
+    return func;
+}
+
+
+void qlow::gen::FunctionGenerator::generateVariableDescriptions(llvm::BasicBlock* entry)
+{
+    unsigned argNo = 1;
+    if (method.thisExpression != nullptr) {
+        debugInfo->declareVariable(*method.thisExpression,
+            session.getVariable(method.thisExpression), false, argNo++, subprogram, entry);
+    }
+    // struct and array arguments live in memory, either in a copy on the
+    // stack or behind the byval pointer, as do all arguments of
+    // tail-recursive methods
+    for (auto* arg : method.arguments) {
+        bool isAddress = arg->type->isStructType() || arg->type->isArrayType() ||
+            method.isTailRecursive;
+        debugInfo->declareVariable(*arg, session.getVariable(arg),
+            isAddress, argNo++, subprogram, entry);
+    }
+    for (auto* var : getLocalVariables(*method.body)) {
+        debugInfo->declareVariable(*var, session.getVariable(var), true, 0, subprogram, entry);
+    }
+}
+
+
+void qlow::gen::FunctionGenerator::setDebugLocation(const CodePosition& pos)
+{
+    if (debugInfo != nullptr)
+        builder.SetCurrentDebugLocation(debugInfo->getLocation(pos, subprogram));
+}
+
+
+void qlow::gen::FunctionGenerator::generateTailRecursion(sem::MethodCallExpression& call)
+{
+    // all arguments are evaluated before the first one is overwritten
+    std::vector<llvm::Value*> values;
+    for (auto& argument : call.arguments)
+        values.push_back(argument->accept(expressionVisitor, builder));
+
+    for (size_t i = 0; i < values.size(); i++)
+        builder.CreateStore(values[i], session.getVariable(method.arguments[i]));
+    builder.CreateBr(tailRecursionBlock);
+}
+
+
+llvm::Value* qlow::gen::FunctionGenerator::generateAllocation(llvm::Value* size, unsigned alignment)
+{
+    size = builder.CreateZExtOrTrunc(size, builder.getInt64Ty());
+    if (alignment > 16) {
+        return builder.CreateCall(generateAlignedAllocator(session, module),
+            { size, builder.getInt64(alignment) });
+    }
+    return builder.CreateCall(generateAllocator(session, module), { size });
+}
+
+
+void qlow::gen::FunctionGenerator::enterRegion(void)
+{
+    llvm::StructType* regionType = getRegionType(getContext());
+    llvm::GlobalVariable* current = getCurrentRegion(session, module);
+
+    llvm::Value* region = createEntryAlloca(regionType);
+    builder.CreateStore(llvm::Constant::getNullValue(regionType), region);
+    llvm::Value* outer = builder.CreateLoad(regionType->getPointerTo(), current, "outerregion");
+    // delete searches the enclosing regions as well
+    builder.CreateStore(builder.CreateBitCast(outer, builder.getInt8PtrTy()),
+        builder.CreateStructGEP(regionType, region, 3));
+    builder.CreateStore(region, current);
+    regions.push_back({ region, outer });
+}
+
+
+void qlow::gen::FunctionGenerator::leaveRegion(void)
+{
+    builder.SetInsertPoint(getCurrentBlock());
+    if (getCurrentBlock()->getTerminator() == nullptr)
+        generateRegionExit(regions.back());
+    regions.pop_back();
+}
+
+
+void qlow::gen::FunctionGenerator::leaveAllRegions(void)
+{
+    for (auto region = regions.rbegin(); region != regions.rend(); ++region)
+        generateRegionExit(*region);
+}
+
+
+void qlow::gen::FunctionGenerator::generateRegionExit(const ActiveRegion& region)
+{
+    builder.CreateCall(generateRegionFree(session, module), { region.region });
+    builder.CreateStore(region.outer, getCurrentRegion(session, module));
+}
+
+
+void qlow::gen::FunctionGenerator::generateDelete(llvm::Value* object, const sem::Type* type)
+{
+    // programs that free memory are linked against the C library
+    if (session.isFreestanding())
+        throw "internal error: delete in a freestanding module";
+
+    llvm::Value* memory = object;
+    if (type->isArrayType()) {
+        llvm::Type* arrayType = session.getLlvmType(type);
+        memory = builder.CreateLoad(arrayType->getStructElementType(0),
+            builder.CreateStructGEP(arrayType, object, 0));
+    }
+    builder.CreateCall(generateDeallocator(session, module),
+        { builder.CreateBitCast(memory, builder.getInt8PtrTy()) });
+}
+
+
+void qlow::gen::FunctionGenerator::clearVariable(const sem::Variable* variable)
+{
+    llvm::Type* type = session.getLlvmType(variable->type);
+    builder.CreateStore(llvm::Constant::getNullValue(type), session.getVariable(variable));
+}
+
+
+void qlow::gen::FunctionGenerator::freeOwnedObject(const sem::Variable* variable)
+{
+    llvm::Value* object = session.getVariable(variable);
+    if (!variable->type->isArrayType())
+        object = builder.CreateLoad(session.getLlvmType(variable->type), object);
+    generateDelete(object, variable->type);
+}
+
+
+size_t qlow::gen::FunctionGenerator::enterOwnedScope(sem::DoEndBlock& block)
+{
+    size_t count = 0;
+    for (auto& [name, variable] : block.scope.getLocals()) {
+        if (variable->isOwned) {
+            clearVariable(variable.get());
+            ownedVariables.push_back(variable.get());
+            count++;
+        }
+    }
+    return count;
+}
+
+
+void qlow::gen::FunctionGenerator::leaveOwnedScope(size_t count)
+{
+    builder.SetInsertPoint(getCurrentBlock());
+    bool returned = getCurrentBlock()->getTerminator() != nullptr;
+    for (size_t i = 0; i < count; i++) {
+        if (!returned)
+            freeOwnedObject(ownedVariables.back());
+        ownedVariables.pop_back();
+    }
+}
+
+
+void qlow::gen::FunctionGenerator::freeOwnedObjects(const sem::Variable* moved)
+{
+    for (auto variable = ownedVariables.rbegin(); variable != ownedVariables.rend(); ++variable) {
+        if (*variable != moved)
+            freeOwnedObject(*variable);
+    }
+}
+
+
+qlow::gen::FunctionGenerator::SoaElement qlow::gen::FunctionGenerator::generateSoaElement(
+    sem::ArrayAccessExpression& access)
+{
+    llvm::Value* array = access.array->accept(expressionVisitor, builder);
+    llvm::Value* index = generateIndex(access.index->accept(expressionVisitor, builder),
+        access.index->type);
+    llvm::Type* arrayStructType = session.getLlvmType(access.array->type);
+
+    llvm::Value* length = builder.CreateLoad(builder.getInt64Ty(),
+        builder.CreateStructGEP(arrayStructType, array, 1));
+    if (access.needsBoundsCheck)
+        generateBoundsCheck(index, length);
+    llvm::Value* columns = builder.CreateLoad(builder.getInt8PtrTy(),
+        builder.CreateStructGEP(arrayStructType, array, 0));
+    return { access.array->type->getArrayOf(), columns, length, index };
+}
+
+
+llvm::Value* qlow::gen::FunctionGenerator::generateSoaFieldAddress(const SoaElement& element,
+    const sem::Field* field)
+{
+    for (auto& column : session.getSoaLayout(element.structType).columns) {
+        if (column.field != field)
+            continue;
+        llvm::Type* fieldType = session.getLlvmType(field->type);
+        llvm::Value* start = element.columns;
+        if (column.offset != 0) {
+            start = builder.CreateGEP(builder.getInt8Ty(), start,
+                builder.CreateMul(element.length, builder.getInt64(column.offset)));
+        }
+        start = builder.CreateBitCast(start, fieldType->getPointerTo());
+        return builder.CreateGEP(fieldType, start, element.index);
+    }
+    throw "internal error: field not found in @soa array";
+}
+
+
+llvm::Value* qlow::gen::FunctionGenerator::generateSoaLoad(const SoaElement& element)
+{
+    llvm::Value* value = llvm::UndefValue::get(session.getLlvmType(element.structType));
+    for (const sem::Field* field : element.structType->getClass()->fieldOrder) {
+        llvm::Value* fieldValue = builder.CreateLoad(session.getLlvmType(field->type),
+            generateSoaFieldAddress(element, field));
+        value = builder.CreateInsertValue(value, fieldValue, { session.getStructIndex(field) });
+    }
+    return value;
+}
+
+
+void qlow::gen::FunctionGenerator::generateSoaStore(const SoaElement& element, llvm::Value* value)
+{
+    for (const sem::Field* field : element.structType->getClass()->fieldOrder) {
+        builder.CreateStore(builder.CreateExtractValue(value, { session.getStructIndex(field) }),
+            generateSoaFieldAddress(element, field));
+    }
+}
+
+
+void qlow::gen::FunctionGenerator::alignAlloca(llvm::AllocaInst* alloca, const sem::Type* type)
+{
+    unsigned alignment = session.getAlignment(type);
+    if (alignment > alloca->getAlign().value())
+        alloca->setAlignment(llvm::Align(alignment));
+}
+
+
+llvm::AllocaInst* qlow::gen::FunctionGenerator::createEntryAlloca(llvm::Type* type)
+{
+    llvm::BasicBlock& entry = builder.GetInsertBlock()->getParent()->getEntryBlock();
+    llvm::IRBuilder<> entryBuilder(&entry, entry.begin());
+    return entryBuilder.CreateAlloca(type);
+}
+
+
+llvm::Value* qlow::gen::FunctionGenerator::generateIndex(llvm::Value* value, const sem::Type* type)
+{
+    auto* nativeType = static_cast<const sem::NativeType*>(type);
+    if (nativeType->isUnsignedType())
+        return builder.CreateZExtOrTrunc(value, builder.getInt64Ty());
+    else
+        return builder.CreateSExtOrTrunc(value, builder.getInt64Ty());
+}
+
+
+void qlow::gen::FunctionGenerator::generateBoundsCheck(llvm::Value* index, llvm::Value* length)
+{
+    using llvm::BasicBlock;
+
+    if (session.getOptions().boundsChecks == Options::BoundsChecks::OFF)
+        return;
+
+    llvm::LLVMContext& context = getContext();
+    llvm::Function* function = builder.GetInsertBlock()->getParent();
+
+    BasicBlock* errorBlock = getBoundsErrorBlock();
+    BasicBlock* inBounds = BasicBlock::Create(context, "inbounds", function);
+
+    if (index->getType() != length->getType())
+        throw "internal error: array index not widened to 64 bits";
+
+    // the index has already been widened by its signedness, so a negative
+    // signed index is a large unsigned number and a single unsigned
+    // comparison checks both bounds
+    llvm::Value* outOfBounds = builder.CreateICmpUGE(index, length, "outofbounds");
+    llvm::MDBuilder mdBuilder(context);
+    builder.CreateCondBr(outOfBounds, errorBlock, inBounds,
+        mdBuilder.createBranchWeights(1, 2000));
+
+    if (boundsErrorIndex != nullptr) {
+        boundsErrorIndex->addIncoming(index, builder.GetInsertBlock());
+        boundsErrorLength->addIncoming(length, builder.GetInsertBlock());
+    }
+
+    builder.SetInsertPoint(inBounds);
+    setCurrentBlock(inBounds);
+}
+
+
+llvm::BasicBlock* qlow::gen::FunctionGenerator::getBoundsErrorBlock(void)
+{
+    if (boundsErrorBlock != nullptr)
+        return boundsErrorBlock;
+
+    llvm::LLVMContext& context = getContext();
+    llvm::Function* function = builder.GetInsertBlock()->getParent();
+    auto insertPoint = builder.saveIP();
+
+    boundsErrorBlock = llvm::BasicBlock::Create(context, "boundserror", function);
+    builder.SetInsertPoint(boundsErrorBlock);
+    if (session.getOptions().boundsChecks == Options::BoundsChecks::TRAP) {
+        builder.CreateCall(llvm::Intrinsic::getDeclaration(module, llvm::Intrinsic::trap));
+    }
+    else {
+        boundsErrorIndex = builder.CreatePHI(builder.getInt64Ty(), 2, "index");
+        boundsErrorLength = builder.CreatePHI(builder.getInt64Ty(), 2, "length");
+        builder.CreateCall(generateBoundsErrorHandler(session, module),
+            { boundsErrorIndex, boundsErrorLength });
+    }
+    builder.CreateUnreachable();
+
+    builder.restoreIP(insertPoint);
+    return boundsErrorBlock;
+}
 
@@ -6,23 +6,183 @@
 #include "CodegenVisitor.h"
 
 #include <stack>
+#include <vector>
+#include <unordered_map>
 
+#include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/DebugInfoMetadata.h>
 
 namespace qlow
 {
+    struct Options;
+
 namespace gen
 {
-    std::unique_ptr<llvm::Module> generateModule(sem::GlobalScope& objects);
-    llvm::Function* generateFunction (llvm::Module* module, sem::Method* method);
-    llvm::Function* generateStartFunction(llvm::Module* module, llvm::Function* start);
-    void generateObjectFile(const std::string& name, std::unique_ptr<llvm::Module> module, int optLevel);
+    class CodegenSession;
+    class DebugInfoGenerator;
+
+    std::unique_ptr<llvm::Module> generateModule(CodegenSession& session, sem::GlobalScope& objects);
+    llvm::Function* generateFunction (CodegenSession& session, llvm::Module* module, sem::Method* method);
+    llvm::Function* generateStartFunction(CodegenSession& session, llvm::Module* module, llvm::Function* start);
+    llvm::Function* generateBoundsErrorHandler(CodegenSession& session, llvm::Module* module);
+    void generateRuntimeFunctions(llvm::Module* module);
+
+    /// returns the type of a region: the next free byte, the end of the
+    /// current chunk, the last allocated chunk and the enclosing region
+    llvm::StructType* getRegionType(llvm::LLVMContext& context);
+    /// returns the global pointing to the region <code>new</code> allocates from
+    llvm::GlobalVariable* getCurrentRegion(CodegenSession& session, llvm::Module* module);
+    llvm::Function* generateAllocator(CodegenSession& session, llvm::Module* module);
+    llvm::Function* generateRegionFree(CodegenSession& session, llvm::Module* module);
+    llvm::Function* generateAlignedAllocator(CodegenSession& session, llvm::Module* module);
+    llvm::Function* generateDeallocator(CodegenSession& session, llvm::Module* module);
+
+    /// checks if the program calls into the C library
+    bool needsCLibrary(const Options& options, sem::GlobalScope& objects);
+    void generateObjectFile(const std::string& name, std::unique_ptr<llvm::Module> module, const Options& options);
 
     class FunctionGenerator;
 }
 }
 
+
+/*!
+ * \brief holds all llvm state of one code generation run
+ *
+ * The semantic tree is never modified during code generation. Instead, the
+ * llvm counterparts of types, fields, methods and variables are stored in
+ * side tables of the session. Independent sessions can therefore generate
+ * code concurrently, also from the same semantic tree.
+ *
+ * Modules generated in a session must not outlive it.
+ */
+class qlow::gen::CodegenSession
+{
+    const Options& options;
+    llvm::LLVMContext llvmContext;
+
+    llvm::DataLayout dataLayout;
+
+    std::unordered_map<const sem::Type*, llvm::Type*> types;
+    std::unordered_map<const sem::Field*, unsigned> structIndices;
+    /// alignments of structs that differ from the one of their llvm type
+    std::unordered_map<const sem::Type*, unsigned> alignments;
+    std::unordered_map<const sem::Method*, llvm::Function*> functions;
+    std::unordered_map<const sem::Variable*, llvm::Value*> variables;
+
+    bool freestanding;
+public:
+    inline CodegenSession(const Options& options) :
+        options{ options },
+        dataLayout{ "" },
+        freestanding{ false }
+    {
+    }
+    CodegenSession(const CodegenSession&) = delete;
+    CodegenSession& operator=(const CodegenSession&) = delete;
+
+    inline const Options& getOptions(void) const { return options; }
+    inline llvm::LLVMContext& getLlvmContext(void) { return llvmContext; }
+
+    /*!
+     * \brief true if the generated module does not use the C library
+     *
+     * Decided by \ref generateModule for <code>--static</code>. The module
+     * then contains its own entry point, error handler and memory
+     * functions, which use system calls instead of the C library.
+     */
+    inline bool isFreestanding(void) const { return freestanding; }
+    inline void setFreestanding(bool freestanding) { this->freestanding = freestanding; }
+
+    /// the data layout of the target, set before any type is lowered
+    inline const llvm::DataLayout& getDataLayout(void) const { return dataLayout; }
+    inline void setDataLayout(const llvm::DataLayout& layout) { dataLayout = layout; }
+
+    /// returns the flags for floating point operations selected by the options
+    llvm::FastMathFlags getFastMathFlags(void) const;
+
+    /*!
+     * \brief returns the llvm type of a semantic type, lowering it on
+     *        first use
+     */
+    llvm::Type* getLlvmType(const sem::Type* type);
+
+    /// returns the alignment of values of a type in bytes, references
+    /// are aligned like pointers
+    unsigned getAlignment(const sem::Type* type);
+
+    /*!
+     * \brief returns the alignment of the struct holding the fields of a
+     *        class or struct type
+     *
+     * Classes with <code>@align(N)</code> are aligned to at least
+     * <code>N</code>, <code>@packed</code> ones to a single byte unless
+     * they also have <code>@align</code>.
+     */
+    unsigned getStructAlignment(const sem::Type* type);
+
+    /*!
+     * \brief returns the index of a field in the llvm struct of its class
+     * \pre the type of the class containing the field has been lowered
+     *      using \ref getLlvmType
+     */
+    unsigned getStructIndex(const sem::Field* field) const;
+
+    /// how the fields of a struct are stored in an @soa array
+    struct SoaLayout
+    {
+        struct Column
+        {
+            const sem::Field* field;
+            /// the column starts <code>length * offset</code> bytes after
+            /// the start of the array
+            uint64_t offset;
+        };
+        std::vector<Column> columns;
+        /// bytes needed per element in all columns together
+        uint64_t elementSize;
+        /// alignment needed by the first column
+        unsigned alignment;
+    };
+
+    /*!
+     * \brief returns the layout of an @soa array of \p structType
+     *
+     * All columns share a single allocation. They are ordered by
+     * decreasing alignment, so that every column is aligned if the
+     * allocation is.
+     */
+    SoaLayout getSoaLayout(const sem::Type* structType);
+
+private:
+    unsigned computeAlignment(const sem::Class* semClass);
+    void lowerClassFields(const sem::Class* semClass, std::vector<llvm::Type*>& structTypes);
+public:
+
+    /*!
+     * \brief checks if values of a type are passed to and returned from
+     *        functions through memory
+     *
+     * Structs of up to two eightbytes are passed as first class aggregates,
+     * which ends up in registers, larger ones are passed using
+     * <code>byval</code> and returned using <code>sret</code> pointers.
+     */
+    bool isPassedInMemory(const sem::Type* type, const llvm::DataLayout& layout);
+
+    llvm::Function* getFunction(const sem::Method* method) const;
+    void setFunction(const sem::Method* method, llvm::Function* function);
+
+    /*!
+     * \brief returns the alloca instance of a local variable or the
+     *        value of a parameter
+     */
+    llvm::Value* getVariable(const sem::Variable* variable) const;
+    void setVariable(const sem::Variable* variable, llvm::Value* value);
+};
+
+
 class qlow::gen::FunctionGenerator
 {
     const sem::Method& method;
@@ -31,21 +191,53 @@ class qlow::gen::FunctionGenerator
 
     std::stack<llvm::BasicBlock*> basicBlocks;
 
+    /// <code>sret</code> argument, if the result is returned in memory
+    llvm::Value* returnSlot = nullptr;
+
+    /// null unless debug information is generated
+    DebugInfoGenerator* debugInfo;
+    llvm::DISubprogram* subprogram = nullptr;
+
+    /// start of the body, target of self-recursive calls in tail position
+    llvm::BasicBlock* tailRecursionBlock = nullptr;
+
+    /// block shared by all failing bounds checks, created on first use
+    llvm::BasicBlock* boundsErrorBlock = nullptr;
+    llvm::PHINode* boundsErrorIndex = nullptr;
+    llvm::PHINode* boundsErrorLength = nullptr;
+
+    struct ActiveRegion
+    {
+        llvm::Value* region;
+        /// the region that was current before
+        llvm::Value* outer;
+    };
+    /// regions entered by the enclosing region blocks, innermost last
+    std::vector<ActiveRegion> regions;
+
+    /// owned variables of the enclosing blocks, innermost last
+    std::vector<const sem::Variable*> ownedVariables;
+
 public:
 
+    CodegenSession& session;
     StatementVisitor statementVisitor;
     ExpressionCodegenVisitor expressionVisitor;
     LValueVisitor lvalueVisitor;
     llvm::IRBuilder<> builder;
 
-    inline FunctionGenerator(const sem::Method& m, llvm::Module* module,
-        llvm::AttributeSet& attributes) :
+    inline FunctionGenerator(CodegenSession& session, const sem::Method& m,
+        llvm::Module* module, llvm::AttributeSet& attributes,
+        DebugInfoGenerator* debugInfo = nullptr) :
         method{ m },
         module{ module },
+        debugInfo{ debugInfo },
         //attributes{ attributes },
+        session{ session },
         expressionVisitor{ *this },
         builder{ module->getContext() }
     {
+        builder.setFastMathFlags(session.getFastMathFlags());
     }
 
     llvm::Function* generate(void);
@@ -55,6 +247,120 @@ public:
     inline llvm::BasicBlock* getCurrentBlock(void) const { return basicBlocks.top(); }
     inline void pushBlock(llvm::BasicBlock* bb) { basicBlocks.push(bb); }
     inline llvm::BasicBlock* popBlock(void) { auto* bb = basicBlocks.top(); basicBlocks.pop(); return bb; }
+    inline llvm::Value* getReturnSlot(void) const { return returnSlot; }
+
+    /// creates an alloca instruction at the start of the function, so it
+    /// is executed only once and can be promoted to registers
+    llvm::AllocaInst* createEntryAlloca(llvm::Type* type);
+
+    /// raises the alignment of a variable to the one of \p type, if that
+    /// is larger than the one of its llvm type
+    void alignAlloca(llvm::AllocaInst* alloca, const sem::Type* type);
+
+    /// replaces the current block after it has been terminated by a branch
+    inline void setCurrentBlock(llvm::BasicBlock* bb) { basicBlocks.top() = bb; }
+
+    /// widens the array index or length \p value of the integer type
+    /// \p type to 64 bits, respecting its signedness
+    llvm::Value* generateIndex(llvm::Value* value, const sem::Type* type);
+
+    /*!
+     * \brief branches to the bounds error block unless
+     *        <code>0 <= index < length</code>
+     *
+     * \p index must already be widened to 64 bits by generateIndex.
+     *
+     * Code generation continues in a new block, which becomes the current
+     * block.
+     */
+    void generateBoundsCheck(llvm::Value* index, llvm::Value* length);
+
+    /// attributes the following instructions to \p pos, if debug
+    /// information is generated
+    void setDebugLocation(const CodePosition& pos);
+
+    /*!
+     * \brief replaces a self-recursive call by assigning the new arguments
+     *        and jumping back to the start of the body
+     *
+     * Terminates the current block.
+     */
+    void generateTailRecursion(sem::MethodCallExpression& call);
+
+    /// an element of an @soa array
+    struct SoaElement
+    {
+        const sem::Type* structType;
+        /// start of the allocation holding all columns
+        llvm::Value* columns;
+        llvm::Value* length;
+        llvm::Value* index;
+    };
+
+    /// evaluates the array and the index of an access to an @soa array
+    /// and checks the bounds if needed
+    SoaElement generateSoaElement(sem::ArrayAccessExpression& access);
+
+    /// returns a pointer to a field of an element of an @soa array
+    llvm::Value* generateSoaFieldAddress(const SoaElement& element, const sem::Field* field);
+
+    /// gathers the fields of an element of an @soa array into a struct value
+    llvm::Value* generateSoaLoad(const SoaElement& element);
+
+    /// stores the fields of a struct value into the columns of an @soa array
+    void generateSoaStore(const SoaElement& element, llvm::Value* value);
+
+    /*!
+     * \brief allocates \p size bytes from the current region or the heap
+     *
+     * Memory is aligned to 16 bytes, or to \p alignment if it is larger.
+     */
+    llvm::Value* generateAllocation(llvm::Value* size, unsigned alignment = 16);
+
+    /// creates an empty region on the stack and makes it the current one
+    void enterRegion(void);
+
+    /*!
+     * \brief frees the innermost region and makes the previous one current
+     *        again, unless the current block has already returned
+     */
+    void leaveRegion(void);
+
+    /// frees all regions entered in this function, before returning from it
+    void leaveAllRegions(void);
+
+    /*!
+     * \brief frees an object or the elements of an array
+     *
+     * \param object the value of an expression of type \p type, which is a
+     *        pointer to the <code>{ elements, length }</code> struct for arrays
+     */
+    void generateDelete(llvm::Value* object, const sem::Type* type);
+
+    /// sets a local variable of a class or array type to null
+    void clearVariable(const sem::Variable* variable);
+
+    /// frees the object held by an owned variable
+    void freeOwnedObject(const sem::Variable* variable);
+
+    /*!
+     * \brief sets the owned variables of \p block to null and remembers them
+     * \return the number of owned variables, to pass to \ref leaveOwnedScope
+     */
+    size_t enterOwnedScope(sem::DoEndBlock& block);
+
+    /// frees the objects of the innermost \p count owned variables, unless
+    /// the current block has already returned
+    void leaveOwnedScope(size_t count);
+
+    /// frees the objects of all owned variables in scope except \p moved,
+    /// before returning
+    void freeOwnedObjects(const sem::Variable* moved);
+
+private:
+    void generateVariableDescriptions(llvm::BasicBlock* entry);
+    void generateRegionExit(const ActiveRegion& region);
+    llvm::BasicBlock* getBoundsErrorBlock(void);
 };
 
 
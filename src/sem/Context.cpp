@@ -65,9 +65,9 @@ sem::Type* Context::getClassType(Class* classType)
 }
 
 
-sem::Type* Context::getArrayType(Type* pointsTo)
+sem::Type* Context::getArrayType(Type* pointsTo, bool soa)
 {
-    auto t = std::unique_ptr<ArrayType>(new ArrayType(pointsTo));
+    auto t = std::unique_ptr<ArrayType>(new ArrayType(pointsTo, soa));
 
     const auto& find = typeMap.find(t.get());
     if (find != typeMap.end()) {
@@ -76,43 +76,12 @@ sem::Type* Context::getArrayType(Type* pointsTo)
     else {
         typeMap[t.get()] = types.size();
         types.push_back(std::move(t));
-        return types[types.size() - 1].get();
+        Type* arrayType = types[types.size() - 1].get();
+        arrayType->setTypeScope(
+            std::make_unique<NativeTypeScope>(generateArrayTypeScope(*this, arrayType))
+        );
+        return arrayType;
     }
 }
 
 
-void Context::createLlvmTypes(llvm::LLVMContext& llvmCtxt)
-{
-    for (auto& type : types) {
-        if (type->isNativeType()) {
-            type->createLlvmTypeDecl(llvmCtxt);
-        }
-        else {
-            // all structs and array types are structs
-            type->llvmType = llvm::StructType::create(llvmCtxt, type->asIdentifier());
-        }
-    }
-    for (auto& type : types) {
-        if (type->isClassType()) {
-            std::vector<llvm::Type*> structTypes;
-
-            for (auto& [name, field] : type->getClass()->fields) {
-                structTypes.push_back(field->type->getLlvmType(llvmCtxt));
-                field->llvmStructIndex = structTypes.size() - 1;
-            }
-
-            llvm::dyn_cast<llvm::StructType>(type->llvmType)->setBody(llvm::ArrayRef(structTypes));
-            if (type->getClass()->isReferenceType)
-                type->llvmType = type->llvmType->getPointerTo();
-        }
-        if (type->isArrayType()) {
-            ArrayType* arrType = static_cast<ArrayType*>(type.get());
-            std::vector<llvm::Type*> structTypes {
-                arrType->elementType->getLlvmType(llvmCtxt)->getPointerTo(),    // elements pointer
-                llvm::Type::getInt64Ty(llvmCtxt)                                // length
-            };
-            llvm::dyn_cast<llvm::StructType>(type->llvmType)->setBody(llvm::ArrayRef(structTypes));
-        }
-    }
-}
-
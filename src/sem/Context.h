@@ -6,9 +6,6 @@
 #include <vector>
 #include <optional>
 
-#include <llvm/IR/Type.h>
-#include <llvm/IR/LLVMContext.h>
-
 #include "Type.h"
 #include "Util.h"
 
@@ -61,11 +58,7 @@ public:
 
     Type* getNativeType(NativeType::NType type);
     Type* getClassType(Class* c);
-    Type* getArrayType(Type* pointsTo);
-
-    //llvm::Type* getLlvmType(TypeId id, llvm::LLVMContext& llvmCtxt);
-
-    void createLlvmTypes(llvm::LLVMContext& llvmCtxt);
+    Type* getArrayType(Type* pointsTo, bool soa = false);
 };
 
 #endif // QLOW_SEM_CONTEXT_H
@@ -0,0 +1,303 @@
+#include "DebugInfo.h"
+#include "CodeGeneration.h"
+#include "Driver.h"
+
+#include <llvm/IR/DataLayout.h>
+#include <llvm/BinaryFormat/Dwarf.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#include <algorithm>
+
+using namespace qlow;
+
+
+static unsigned getLine(const CodePosition& pos)
+{
+    return static_cast<unsigned>(std::max(pos.first_line, 0));
+}
+
+
+gen::DebugInfoGenerator::DebugInfoGenerator(CodegenSession& session, llvm::Module& module) :
+    session{ session },
+    module{ module },
+    builder{ module },
+    compileUnit{ nullptr },
+    lineTablesOnly{ session.getOptions().debugInfo != Options::DebugInfo::FULL }
+{
+    const Options& options = session.getOptions();
+    module.addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    module.addModuleFlag(llvm::Module::Max, "Dwarf Version", 4);
+
+    CodePosition mainFile = CodePosition::none();
+    if (!options.infiles.empty())
+        mainFile.filename = options.infiles.front();
+
+    // without -g, the locations are only tracked for optimization remarks
+    // and no debug information is emitted
+    llvm::DICompileUnit::DebugEmissionKind kind = llvm::DICompileUnit::NoDebug;
+    if (options.debugInfo == Options::DebugInfo::FULL)
+        kind = llvm::DICompileUnit::FullDebug;
+    else if (options.debugInfo == Options::DebugInfo::LINE_TABLES_ONLY)
+        kind = llvm::DICompileUnit::LineTablesOnly;
+
+    // there is no language code for qlow, debuggers handle it like C
+    compileUnit = builder.createCompileUnit(llvm::dwarf::DW_LANG_C, getFile(mainFile),
+        "qlow", options.optLevel > 0, "", 0, "", kind);
+}
+
+
+llvm::DIFile* gen::DebugInfoGenerator::getFile(const CodePosition& pos)
+{
+    if (pos.filename.empty() && compileUnit != nullptr)
+        return compileUnit->getFile();
+
+    llvm::DIFile*& file = files[pos.filename];
+    if (file == nullptr) {
+        llvm::SmallString<128> path(pos.filename);
+        llvm::sys::fs::make_absolute(path);
+        file = builder.createFile(llvm::sys::path::filename(path),
+            llvm::sys::path::parent_path(path));
+    }
+    return file;
+}
+
+
+llvm::DebugLoc gen::DebugInfoGenerator::getLocation(const CodePosition& pos, llvm::DIScope* scope)
+{
+    return llvm::DILocation::get(module.getContext(), getLine(pos),
+        static_cast<unsigned>(std::max(pos.first_column, 0)), scope);
+}
+
+
+llvm::DISubprogram* gen::DebugInfoGenerator::createSubprogram(const sem::Method& method,
+    llvm::Function* function)
+{
+    const CodePosition& pos = method.astNode ? method.astNode->pos : CodePosition::none();
+    llvm::DIFile* file = getFile(pos);
+    std::string name = method.containingClass != nullptr ?
+        method.containingClass->name + "." + method.name : method.name;
+
+    llvm::DISubprogram::DISPFlags flags = llvm::DISubprogram::SPFlagDefinition;
+    if (session.getOptions().optLevel > 0)
+        flags |= llvm::DISubprogram::SPFlagOptimized;
+
+    llvm::DISubprogram* subprogram = builder.createFunction(file, name, function->getName(),
+        file, getLine(pos), createSubroutineType(method), getLine(pos),
+        llvm::DINode::FlagPrototyped, flags);
+    function->setSubprogram(subprogram);
+    return subprogram;
+}
+
+
+void gen::DebugInfoGenerator::createArtificialSubprogram(llvm::Function* function,
+    const CodePosition& pos)
+{
+    llvm::DIFile* file = getFile(pos);
+
+    llvm::DISubprogram::DISPFlags flags = llvm::DISubprogram::SPFlagDefinition;
+    if (session.getOptions().optLevel > 0)
+        flags |= llvm::DISubprogram::SPFlagOptimized;
+
+    llvm::DISubprogram* subprogram = builder.createFunction(file, function->getName(),
+        function->getName(), file, getLine(pos),
+        builder.createSubroutineType(builder.getOrCreateTypeArray({})), getLine(pos),
+        llvm::DINode::FlagArtificial | llvm::DINode::FlagPrototyped, flags);
+    function->setSubprogram(subprogram);
+
+    llvm::DebugLoc location = getLocation(pos, subprogram);
+    for (llvm::BasicBlock& block : *function) {
+        for (llvm::Instruction& instruction : block)
+            instruction.setDebugLoc(location);
+    }
+    finalizeSubprogram(subprogram);
+}
+
+
+void gen::DebugInfoGenerator::finalizeSubprogram(llvm::DISubprogram* subprogram)
+{
+    builder.finalizeSubprogram(subprogram);
+}
+
+
+void gen::DebugInfoGenerator::declareVariable(const sem::Variable& variable, llvm::Value* storage,
+    bool isAddress, unsigned argNo, llvm::DISubprogram* subprogram, llvm::BasicBlock* block)
+{
+    if (lineTablesOnly)
+        return;
+
+    llvm::DIFile* file = getFile(variable.pos);
+    llvm::DIType* type = getType(variable.type);
+    llvm::DINode::DIFlags flags = llvm::DINode::FlagZero;
+    if (dynamic_cast<const sem::ThisExpression*>(&variable) != nullptr) {
+        flags = llvm::DINode::FlagArtificial | llvm::DINode::FlagObjectPointer;
+        // methods of structs work on a pointer to the struct
+        if (variable.type->isStructType())
+            type = builder.createPointerType(type, module.getDataLayout().getPointerSizeInBits());
+    }
+
+    // when optimizing, variables are kept to show them as optimized out
+    bool preserve = session.getOptions().optLevel > 0;
+    llvm::DILocalVariable* description = argNo > 0 ?
+        builder.createParameterVariable(subprogram, variable.name, argNo, file,
+            getLine(variable.pos), type, preserve, flags) :
+        builder.createAutoVariable(subprogram, variable.name, file,
+            getLine(variable.pos), type, preserve, flags);
+
+    llvm::DebugLoc location = getLocation(variable.pos, subprogram);
+    if (isAddress) {
+        builder.insertDeclare(storage, description, builder.createExpression(),
+            location.get(), block);
+    }
+    else {
+        builder.insertDbgValueIntrinsic(storage, description, builder.createExpression(),
+            location.get(), block);
+    }
+}
+
+
+llvm::DIType* gen::DebugInfoGenerator::getType(const sem::Type* type)
+{
+    if (auto t = types.find(type); t != types.end())
+        return t->second;
+
+    if (type->isNativeType()) {
+        llvm::DIType* diType = createNativeType(static_cast<const sem::NativeType*>(type));
+        types[type] = diType;
+        return diType;
+    }
+    return createStructType(type);
+}
+
+
+void gen::DebugInfoGenerator::finalize(void)
+{
+    builder.finalize();
+}
+
+
+llvm::DIType* gen::DebugInfoGenerator::createNativeType(const sem::NativeType* type)
+{
+    if (type->isVoid())
+        return nullptr;
+
+    const llvm::DataLayout& layout = module.getDataLayout();
+    llvm::Type* llvmType = session.getLlvmType(type);
+
+    unsigned encoding = llvm::dwarf::DW_ATE_signed;
+    if (type->isFloatingPointType())
+        encoding = llvm::dwarf::DW_ATE_float;
+    else if (type->getNativeType() == sem::NativeType::NType::BOOLEAN)
+        encoding = llvm::dwarf::DW_ATE_boolean;
+    else if (type->isUnsignedType())
+        encoding = llvm::dwarf::DW_ATE_unsigned;
+
+    if (!type->isVectorType()) {
+        return builder.createBasicType(type->asString(),
+            layout.getTypeAllocSizeInBits(llvmType), encoding);
+    }
+
+    llvm::Type* laneType = llvm::cast<llvm::VectorType>(llvmType)->getElementType();
+    std::string laneName = (type->isFloatingPointType() ? "Float" : "Int") +
+        std::to_string(laneType->getPrimitiveSizeInBits());
+    llvm::DIType* lane = builder.createBasicType(laneName,
+        layout.getTypeAllocSizeInBits(laneType), encoding);
+    llvm::Metadata* lanes = builder.getOrCreateSubrange(0, type->getLaneCount());
+    return builder.createVectorType(layout.getTypeAllocSizeInBits(llvmType),
+        layout.getABITypeAlign(llvmType).value() * 8, lane, builder.getOrCreateArray({ lanes }));
+}
+
+
+/*!
+ * Reference types are described as pointers to the struct. The struct is
+ * registered as a forward declaration first, so that fields can refer to
+ * the type containing them.
+ */
+llvm::DIType* gen::DebugInfoGenerator::createStructType(const sem::Type* type)
+{
+    const llvm::DataLayout& layout = module.getDataLayout();
+    const unsigned pointerSize = layout.getPointerSizeInBits();
+
+    const CodePosition& pos = type->isClassType() && type->getClass()->astNode != nullptr ?
+        type->getClass()->astNode->pos : CodePosition::none();
+    llvm::DIFile* file = getFile(pos);
+
+    llvm::DICompositeType* forward = builder.createReplaceableCompositeType(
+        llvm::dwarf::DW_TAG_structure_type, type->asString(), file, file, getLine(pos));
+    if (type->isReferenceType())
+        types[type] = builder.createPointerType(forward, pointerSize);
+    else
+        types[type] = forward;
+
+    llvm::Type* llvmType = session.getLlvmType(type);
+    auto* structType = llvm::cast<llvm::StructType>(type->isReferenceType() ?
+        llvmType->getPointerElementType() : llvmType);
+    const llvm::StructLayout* structLayout = layout.getStructLayout(structType);
+
+    std::vector<llvm::Metadata*> members;
+    auto addMember = [&] (const std::string& name, const CodePosition& memberPos,
+        unsigned index, llvm::DIType* memberType) {
+        llvm::Type* elementType = structType->getElementType(index);
+        members.push_back(builder.createMemberType(forward, name, getFile(memberPos),
+            getLine(memberPos), layout.getTypeAllocSizeInBits(elementType),
+            layout.getABITypeAlign(elementType).value() * 8,
+            structLayout->getElementOffsetInBits(index), llvm::DINode::FlagZero, memberType));
+    };
+
+    if (type->isClassType()) {
+        for (auto* field : type->getClass()->fieldOrder) {
+            addMember(field->name, field->pos, session.getStructIndex(field), getType(field->type));
+        }
+    }
+    else if (type->isArrayType()) {
+        sem::Type* length = type->getContext().getNativeType(sem::NativeType::NType::INT64);
+        // the columns of @soa arrays have no type of their own
+        if (type->isSoaArrayType()) {
+            addMember("columns", pos, 0, builder.createPointerType(nullptr, pointerSize));
+        }
+        else {
+            addMember("elements", pos, 0,
+                builder.createPointerType(getType(type->getArrayOf()), pointerSize));
+        }
+        addMember("length", pos, 1, getType(length));
+    }
+
+    llvm::DICompositeType* complete = builder.createStructType(file, type->asString(), file,
+        getLine(pos), layout.getTypeAllocSizeInBits(structType),
+        layout.getABITypeAlign(structType).value() * 8, llvm::DINode::FlagZero, nullptr,
+        builder.getOrCreateArray(members));
+    // also updates the pointer type referring to the forward declaration
+    builder.replaceTemporary(llvm::TempMDNode(forward), complete);
+
+    if (!type->isReferenceType())
+        types[type] = complete;
+    return types[type];
+}
+
+
+llvm::DISubroutineType* gen::DebugInfoGenerator::createSubroutineType(const sem::Method& method)
+{
+    if (lineTablesOnly)
+        return builder.createSubroutineType(builder.getOrCreateTypeArray({}));
+
+    // the first element is the return type, null for methods without one
+    std::vector<llvm::Metadata*> elements;
+    if (method.returnType != nullptr)
+        elements.push_back(getType(method.returnType));
+    else
+        elements.push_back(nullptr);
+
+    if (method.thisExpression != nullptr) {
+        llvm::DIType* thisType = getType(method.thisExpression->type);
+        if (method.thisExpression->type->isStructType()) {
+            thisType = builder.createPointerType(thisType,
+                module.getDataLayout().getPointerSizeInBits());
+        }
+        elements.push_back(builder.createObjectPointerType(thisType));
+    }
+    for (auto* argument : method.arguments)
+        elements.push_back(getType(argument->type));
+
+    return builder.createSubroutineType(builder.getOrCreateTypeArray(elements));
+}
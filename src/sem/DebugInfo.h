@@ -0,0 +1,98 @@
+#ifndef QLOW_SEM_DEBUGINFO_H
+#define QLOW_SEM_DEBUGINFO_H
+
+#include "Semantic.h"
+
+#include <map>
+#include <unordered_map>
+
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Module.h>
+
+namespace qlow
+{
+    struct Options;
+
+namespace gen
+{
+    class CodegenSession;
+    class DebugInfoGenerator;
+}
+}
+
+
+/*!
+ * \brief emits the DWARF metadata of one module
+ *
+ * Locations are taken from the \ref CodePosition of the semantic objects.
+ * With <code>-gline-tables-only</code>, only subprograms and line tables
+ * are emitted, which do not influence the optimizations. Optimization
+ * remarks without <code>-g</code> use the same locations, but nothing is
+ * emitted into the object file.
+ */
+class qlow::gen::DebugInfoGenerator
+{
+    CodegenSession& session;
+    llvm::Module& module;
+    llvm::DIBuilder builder;
+    llvm::DICompileUnit* compileUnit;
+    bool lineTablesOnly;
+
+    std::map<std::string, llvm::DIFile*> files;
+    std::unordered_map<const sem::Type*, llvm::DIType*> types;
+public:
+    DebugInfoGenerator(CodegenSession& session, llvm::Module& module);
+    DebugInfoGenerator(const DebugInfoGenerator&) = delete;
+    DebugInfoGenerator& operator=(const DebugInfoGenerator&) = delete;
+
+    /// true if variables and types are not described
+    inline bool isLineTablesOnly(void) const { return lineTablesOnly; }
+
+    /// returns the file a position refers to, or the main file if it has none
+    llvm::DIFile* getFile(const CodePosition& pos);
+
+    /// returns the line table entry of \p pos inside of \p scope
+    llvm::DebugLoc getLocation(const CodePosition& pos, llvm::DIScope* scope);
+
+    /*!
+     * \brief creates the subprogram of a method and attaches it to its
+     *        function
+     */
+    llvm::DISubprogram* createSubprogram(const sem::Method& method, llvm::Function* function);
+
+    /*!
+     * \brief creates a subprogram for a function that does not correspond
+     *        to a method, like <code>_qlow_start</code>
+     *
+     * All instructions in \p function are attributed to \p pos.
+     */
+    void createArtificialSubprogram(llvm::Function* function, const CodePosition& pos);
+
+    /// resolves the variables of a subprogram after its function is complete
+    void finalizeSubprogram(llvm::DISubprogram* subprogram);
+
+    /*!
+     * \brief describes a local variable or parameter
+     *
+     * \param storage the alloca or the pointer holding the variable, or its
+     *        value if \p isAddress is not set
+     * \param argNo the 1-based index of a parameter, 0 for local variables
+     */
+    void declareVariable(const sem::Variable& variable, llvm::Value* storage, bool isAddress,
+        unsigned argNo, llvm::DISubprogram* subprogram, llvm::BasicBlock* block);
+
+    /// returns the debug type of a semantic type, creating it on first use
+    llvm::DIType* getType(const sem::Type* type);
+
+    /// resolves all forward references, must be called before the module is emitted
+    void finalize(void);
+
+private:
+    llvm::DIType* createNativeType(const sem::NativeType* type);
+    llvm::DIType* createStructType(const sem::Type* type);
+    llvm::DISubroutineType* createSubroutineType(const sem::Method& method);
+};
+
+
+#endif // QLOW_SEM_DEBUGINFO_H
@@ -0,0 +1,233 @@
+#include "Ownership.h"
+#include "Semantic.h"
+#include "Traversal.h"
+#include "ErrorReporting.h"
+
+#include <set>
+#include <algorithm>
+#include <iterator>
+
+using namespace qlow::sem;
+
+namespace
+{
+
+const Variable* getLocalVariable(const Expression& expr)
+{
+    if (auto* lve = dynamic_cast<const LocalVariableExpression*>(&expr))
+        return lve->var;
+    return nullptr;
+}
+
+
+/*!
+ * \brief the variables freed on every path to the current statement
+ *
+ * \ref returned is set if no path reaches the statement, the freed
+ * variables are meaningless then.
+ */
+struct State
+{
+    std::set<const Variable*> freed;
+    bool returned = false;
+
+    /// the state after either this or \p other was executed
+    void merge(const State& other)
+    {
+        if (other.returned)
+            return;
+        if (returned) {
+            *this = other;
+            return;
+        }
+        std::set<const Variable*> both;
+        std::set_intersection(freed.begin(), freed.end(),
+            other.freed.begin(), other.freed.end(), std::inserter(both, both.begin()));
+        freed = std::move(both);
+    }
+};
+
+
+/// collects the variables declared in \p block and its nested blocks
+std::set<const Variable*> getDeclaredVariables(DoEndBlock& block)
+{
+    std::set<const Variable*> declared;
+    forEachStatement(block, [&declared] (Statement& s) {
+        if (auto* nested = dynamic_cast<DoEndBlock*>(&s)) {
+            for (const auto& [name, var] : nested->scope.getLocals())
+                declared.insert(var.get());
+        }
+    });
+    return declared;
+}
+
+
+class OwnershipCheck
+{
+    State state;
+
+    /// unset while the state at the start of a loop is searched
+    bool report = true;
+
+    /// the variables declared in the innermost region block, if any
+    const std::set<const Variable*>* regionVariables = nullptr;
+public:
+    void checkUses(Expression& expr)
+    {
+        if (!report)
+            return;
+        forEachExpression(expr, [this] (Expression& e) {
+            const Variable* var = getLocalVariable(e);
+            if (var != nullptr && state.freed.count(var))
+                throw qlow::SemanticError(qlow::SemanticError::USE_AFTER_FREE,
+                    "'" + var->name + "'", e.pos);
+        });
+    }
+
+
+    /*!
+     * \brief rejects giving an owned variable declared outside of the
+     *        innermost region an object that may come from the region
+     *
+     * The variable would free the object after the region is gone. Only
+     * objects moved from other owned variables declared outside of the
+     * region are accepted.
+     */
+    void checkRegionAssignment(const Variable& target, const Variable* moved,
+        const AssignmentStatement& assignment)
+    {
+        if (regionVariables == nullptr || !target.isOwned || regionVariables->count(&target))
+            return;
+        if (moved != nullptr && moved->isOwned && !regionVariables->count(moved))
+            return;
+        throw qlow::SemanticError(qlow::SemanticError::OWNED_OUTLIVES_REGION,
+            "'" + target.name + "'", assignment.pos);
+    }
+
+
+    /*!
+     * \brief runs the body of a loop until the state at its start is
+     *        known, then checks it with that state
+     *
+     * \param iteration checks the condition and the body once
+     */
+    template<typename F>
+    void checkLoop(F iteration)
+    {
+        const State before = state;
+        State start = before;
+        bool reportLoop = report;
+        report = false;
+        while (true) {
+            state = start;
+            iteration();
+            State next = before;
+            next.merge(state);
+            if (next.freed == start.freed)
+                break;
+            start = next;
+        }
+        report = reportLoop;
+
+        state = start;
+        iteration();
+        // the loop is left at its start
+        state = start;
+    }
+
+
+    void check(Statement& statement)
+    {
+        if (state.returned)
+            return;
+
+        if (auto* block = dynamic_cast<DoEndBlock*>(&statement)) {
+            for (auto& s : block->statements)
+                check(*s);
+        }
+        else if (auto* ifElse = dynamic_cast<IfElseBlock*>(&statement)) {
+            checkUses(*ifElse->condition);
+            State before = state;
+            check(*ifElse->ifBlock);
+            State afterIf = state;
+            state = before;
+            if (ifElse->elseBlock)
+                check(*ifElse->elseBlock);
+            state.merge(afterIf);
+        }
+        else if (auto* match = dynamic_cast<MatchBlock*>(&statement)) {
+            checkUses(*match->value);
+            const State before = state;
+            State after = before;
+            after.returned = true;
+            for (auto& c : match->cases) {
+                state = before;
+                check(*c.body);
+                after.merge(state);
+            }
+            state = before;
+            if (match->elseBlock)
+                check(*match->elseBlock);
+            after.merge(state);
+            state = after;
+        }
+        else if (auto* region = dynamic_cast<RegionBlock*>(&statement)) {
+            const std::set<const Variable*> declared = getDeclaredVariables(*region->body);
+            const std::set<const Variable*>* outer = regionVariables;
+            regionVariables = &declared;
+            check(*region->body);
+            regionVariables = outer;
+        }
+        else if (auto* loop = dynamic_cast<WhileBlock*>(&statement)) {
+            checkLoop([&] () {
+                checkUses(*loop->condition);
+                check(*loop->body);
+            });
+            checkUses(*loop->condition);
+        }
+        else if (auto* loop = dynamic_cast<ForBlock*>(&statement)) {
+            forEachOwnExpression(*loop, [this] (Expression& e) { checkUses(e); });
+            checkLoop([&] () {
+                check(*loop->body);
+            });
+        }
+        else if (auto* assignment = dynamic_cast<AssignmentStatement*>(&statement)) {
+            checkUses(*assignment->value);
+            const Variable* target = getLocalVariable(*assignment->target);
+            if (target == nullptr) {
+                checkUses(*assignment->target);
+                return;
+            }
+            const Variable* moved = getLocalVariable(*assignment->value);
+            checkRegionAssignment(*target, moved, *assignment);
+            if (target->isOwned && moved != nullptr && moved->isOwned && moved != target)
+                state.freed.insert(moved);
+            state.freed.erase(target);
+        }
+        else if (auto* del = dynamic_cast<DeleteStatement*>(&statement)) {
+            checkUses(*del->value);
+            if (const Variable* var = getLocalVariable(*del->value))
+                state.freed.insert(var);
+        }
+        else if (auto* ret = dynamic_cast<ReturnStatement*>(&statement)) {
+            if (ret->value)
+                checkUses(*ret->value);
+            state.returned = true;
+        }
+        else {
+            forEachOwnExpression(statement, [this] (Expression& e) { checkUses(e); });
+        }
+    }
+};
+
+} // namespace
+
+
+void qlow::sem::checkOwnership(Method& method)
+{
+    if (!method.body)
+        return;
+
+    OwnershipCheck check;
+    check.check(*method.body);
+}
@@ -0,0 +1,31 @@
+#ifndef QLOW_SEM_OWNERSHIP_H
+#define QLOW_SEM_OWNERSHIP_H
+
+namespace qlow
+{
+    namespace sem
+    {
+        struct Method;
+
+        /*!
+         * \brief rejects uses of local variables whose object is freed
+         *
+         * A local variable counts as freed after <code>delete x</code> and,
+         * if it is owned, after its object has been moved into another
+         * owned variable, until it is assigned again. Only variables that
+         * are freed on every path to a use are reported, objects reachable
+         * through other references are not tracked.
+         *
+         * Owned variables declared outside of a region block may not be
+         * given an object inside of it, as they would free it after the
+         * region is gone.
+         *
+         * \throws SemanticError with \ref SemanticError::USE_AFTER_FREE or
+         *         \ref SemanticError::OWNED_OUTLIVES_REGION
+         */
+        void checkOwnership(Method& method);
+    }
+}
+
+
+#endif // QLOW_SEM_OWNERSHIP_H
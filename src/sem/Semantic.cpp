@@ -2,6 +2,9 @@
 #include "Type.h"
 #include "Ast.h"
 #include "AstVisitor.h"
+#include "BoundsAnalysis.h"
+#include "TailCalls.h"
+#include "Ownership.h"
 #include "Mangling.h"
 #include "Linking.h"
 
@@ -48,6 +51,7 @@ std::pair<std::unique_ptr<Context>, std::unique_ptr<GlobalScope>>
     
     // create all methods and fields
     for (auto& [name, semClass] : globalScope->classes) {
+        av.applyAnnotations(*semClass, *semClass->astNode);
         for (auto& feature : semClass->astNode->features) {
             
             if (auto* field = dynamic_cast<qlow::ast::FieldDeclaration*> (feature.get()); field) {
@@ -56,6 +60,7 @@ std::pair<std::unique_ptr<Context>, std::unique_ptr<GlobalScope>>
                 
                 // otherwise add to the fields list
                 semClass->fields[field->name] = unique_dynamic_cast<Field>(field->accept(av, semClass->scope));
+                semClass->fieldOrder.push_back(semClass->fields[field->name].get());
             }
             else if (auto* method = dynamic_cast<qlow::ast::MethodDefinition*> (feature.get()); method) {
                 if (semClass->methods.find(method->name) != semClass->methods.end()) // throw, if method already exists
@@ -103,14 +108,27 @@ std::pair<std::unique_ptr<Context>, std::unique_ptr<GlobalScope>>
                 method->containingClass = semClass.get();
                 method->generateThisExpression();
                 method->body = unique_dynamic_cast<sem::DoEndBlock>(method->astNode->body->accept(av, method->scope));
+                eliminateBoundsChecks(*method);
+                checkOwnership(*method);
             }
         }
     }
     for (auto& [name, method] : globalScope->functions) {
         if (method->astNode->body) { // if not declaration
             method->body = unique_dynamic_cast<sem::DoEndBlock>(method->astNode->body->accept(av, method->scope));
+            eliminateBoundsChecks(*method);
+            checkOwnership(*method);
         }
     }
+
+    // tail calls compare the signatures of caller and callee, so all
+    // methods must be complete
+    for (auto& [name, semClass] : globalScope->classes) {
+        for (auto& [name, method] : semClass->methods)
+            markTailCalls(*method);
+    }
+    for (auto& [name, method] : globalScope->functions)
+        markTailCalls(*method);
     
 #ifdef DEBUGGING
     printf("created all method bodies\n");
@@ -202,6 +220,7 @@ ACCEPT_DEFINITION(FieldAccessExpression, ExpressionCodegenVisitor, llvm::Value*,
 ACCEPT_DEFINITION(AddressExpression, ExpressionCodegenVisitor, llvm::Value*, llvm::IRBuilder<>&)
 ACCEPT_DEFINITION(ArrayAccessExpression, ExpressionCodegenVisitor, llvm::Value*, llvm::IRBuilder<>&)
 ACCEPT_DEFINITION(IntConst, ExpressionCodegenVisitor, llvm::Value*, llvm::IRBuilder<>&)
+ACCEPT_DEFINITION(FloatConst, ExpressionCodegenVisitor, llvm::Value*, llvm::IRBuilder<>&)
 ACCEPT_DEFINITION(ThisExpression, ExpressionCodegenVisitor, llvm::Value*, llvm::IRBuilder<>&)
 
 ACCEPT_DEFINITION(Expression, LValueVisitor, llvm::Value*, qlow::gen::FunctionGenerator&)
@@ -213,7 +232,11 @@ ACCEPT_DEFINITION(AssignmentStatement, StatementVisitor, llvm::Value*, qlow::gen
 ACCEPT_DEFINITION(DoEndBlock, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
 ACCEPT_DEFINITION(IfElseBlock, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
 ACCEPT_DEFINITION(WhileBlock, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
+ACCEPT_DEFINITION(ForBlock, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
+ACCEPT_DEFINITION(MatchBlock, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
+ACCEPT_DEFINITION(RegionBlock, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
 ACCEPT_DEFINITION(ReturnStatement, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
+ACCEPT_DEFINITION(DeleteStatement, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
 ACCEPT_DEFINITION(FeatureCallStatement, StatementVisitor, llvm::Value*, qlow::gen::FunctionGenerator&) 
 
 std::string AssignmentStatement::toString(void) const
@@ -286,6 +309,13 @@ std::string MethodCallExpression::toString(void) const
 }
 
 
+bool FieldAccessExpression::isSoaField(void) const
+{
+    auto* access = dynamic_cast<const ArrayAccessExpression*>(target.get());
+    return access != nullptr && access->array->type->isSoaArrayType();
+}
+
+
 std::string FieldAccessExpression::toString(void) const
 {
     if (this->target)
@@ -301,6 +331,12 @@ std::string IntConst::toString(void) const
 }
 
 
+std::string FloatConst::toString(void) const
+{
+    return "FloatConst[" + std::to_string(value) + "]";
+}
+
+
 std::string FeatureCallStatement::toString(void) const
 {
     return "FeatureCallStatement[" + expr->callee->toString() + "]";
@@ -37,9 +37,13 @@ namespace qlow
         struct DoEndBlock;
         struct IfElseBlock;
         struct WhileBlock;
+        struct ForBlock;
+        struct MatchBlock;
+        struct RegionBlock;
         struct FeatureCallStatement;
         struct AssignmentStatement;
         struct ReturnStatement;
+        struct DeleteStatement;
         
         struct LocalVariableExpression;
         struct AddressExpression;
@@ -58,6 +62,7 @@ namespace qlow
         struct FieldAccessExpression;
         
         struct IntConst;
+        struct FloatConst;
     }
 
     class ExpressionCodegenVisitor;
@@ -77,13 +82,17 @@ struct qlow::sem::Class : public SemanticObject
     std::string name;
     bool isReferenceType;
     SymbolTable<Field> fields;
+    /// the fields in the order of their declaration
+    std::vector<Field*> fieldOrder;
     SymbolTable<Method> methods;
+
+    /// set by <code>@packed</code>, the fields are stored without padding
+    bool packed = false;
+    /// minimum alignment set by <code>@align(N)</code>, 0 if there is none
+    unsigned alignment = 0;
     ClassScope scope;
     Type* classType;
 
-    /// \brief generated during llvm code generation, not availab
-    llvm::Type* llvmType;
-
     inline Class(qlow::ast::Class* astNode,
             GlobalScope& globalScope) :
         SemanticObject{ globalScope.getContext() },
@@ -91,8 +100,7 @@ struct qlow::sem::Class : public SemanticObject
         name{ astNode->name },
         isReferenceType{ astNode->isReferenceType },
         scope{ globalScope, this },
-        classType{ globalScope.getContext().getClassType(this) },
-        llvmType{ nullptr }
+        classType{ globalScope.getContext().getClassType(this) }
     {
     }
 
@@ -101,8 +109,7 @@ struct qlow::sem::Class : public SemanticObject
         SemanticObject{ globalScope.getContext() },
         astNode{ nullptr },
         name{ nativeName },
-        scope{ globalScope, this },
-        llvmType{ nullptr }
+        scope{ globalScope, this }
     {
     }
 
@@ -117,18 +124,18 @@ struct qlow::sem::Variable : public SemanticObject
     Type* type;
     std::string name;
     bool isParameter;
-
-    /// if this is a local variable, this stores a reference to the llvm
-    /// instance of this variable. If it is a parameter, the parameter value
-    llvm::Value* allocaInst;
+    /// declared as <code>owned</code>: holds null or an object that is
+    /// freed when the block declaring the variable is left
+    bool isOwned = false;
+    /// position of the declaration, used for debug information
+    CodePosition pos = CodePosition::none();
     
     inline Variable(Context& context) :
         SemanticObject{ context } {}
     inline Variable(Context& context, Type* type, const std::string& name) :
         SemanticObject{ context },
         type{ type },
-        name{ name },
-        allocaInst { nullptr }
+        name{ name }
     {
     }
         
@@ -141,13 +148,31 @@ struct qlow::sem::Field : public Variable
     inline Field(Context& context) :
         Variable{ context } {}
 
-    int llvmStructIndex;
     virtual std::string toString(void) const override;
 };
 
 
 struct qlow::sem::Method : public SemanticObject
 {
+    /// inlining hint given by an <code>@inline</code>,
+    /// <code>@noinline</code> or <code>@always_inline</code> annotation
+    enum class Inlining
+    {
+        DEFAULT,
+        INLINE,
+        NO_INLINE,
+        ALWAYS_INLINE,
+    };
+
+    /// expected execution frequency given by a <code>@hot</code> or
+    /// <code>@cold</code> annotation
+    enum class Hotness
+    {
+        DEFAULT,
+        HOT,
+        COLD,
+    };
+
     Class* containingClass;
     Type* returnType;
     std::vector<Variable*> arguments;
@@ -156,11 +181,19 @@ struct qlow::sem::Method : public SemanticObject
     ThisExpression* thisExpression;
     std::unique_ptr<DoEndBlock> body;
     bool isExtern;
+    Inlining inlining;
+    Hotness hotness;
+    /// cpu features to compile additional versions for, given by a
+    /// <code>@target_clones</code> annotation
+    std::vector<std::string> targetClones;
+    /// set by a <code>@tailcall</code> annotation, requires all calls in
+    /// tail position to be compiled as jumps
+    bool guaranteedTailCalls;
+    /// true if some self-recursive call is turned into a loop
+    bool isTailRecursive;
 
     LocalScope scope;
 
-    llvm::Function* llvmNode;
-
     inline Method(Scope& parentScope,
             Type* returnType, bool isExtern) :
         SemanticObject{ parentScope.getContext() },
@@ -169,6 +202,10 @@ struct qlow::sem::Method : public SemanticObject
         thisExpression{ nullptr },
         body{ nullptr },
         isExtern{ isExtern },
+        inlining{ Inlining::DEFAULT },
+        hotness{ Hotness::DEFAULT },
+        guaranteedTailCalls{ false },
+        isTailRecursive{ false },
         scope{ parentScope, this }
     {
     }
@@ -183,6 +220,10 @@ struct qlow::sem::Method : public SemanticObject
         thisExpression{ nullptr },
         body{ nullptr },
         isExtern{ astNode->isExtern() },
+        inlining{ Inlining::DEFAULT },
+        hotness{ Hotness::DEFAULT },
+        guaranteedTailCalls{ false },
+        isTailRecursive{ false },
         scope{ parentScope, this }
     {
     }
@@ -214,6 +255,9 @@ struct qlow::sem::ThisExpression : public Variable
 
 struct qlow::sem::Statement : public SemanticObject, public Visitable<llvm::Value*, gen::FunctionGenerator, qlow::StatementVisitor>
 {
+    /// position of the statement, used for debug information
+    CodePosition pos = CodePosition::none();
+
     inline Statement(Context& context) :
         SemanticObject{ context } {}
     virtual llvm::Value* accept(qlow::StatementVisitor&, gen::FunctionGenerator&) = 0;
@@ -268,6 +312,80 @@ struct qlow::sem::WhileBlock : public Statement
 };
 
 
+/*!
+ * \brief counted loop over a range <code>from..to</code> or over the
+ *        elements of an array
+ *
+ * The bounds are evaluated once before the first iteration, assigning to
+ * the loop variable does not change the iteration.
+ */
+struct qlow::sem::ForBlock : public Statement
+{
+    /// contains only the loop variable
+    LocalScope scope;
+    Variable* variable;
+    std::unique_ptr<Expression> from;
+    std::unique_ptr<Expression> to;
+    /// set instead of \ref from and \ref to when iterating over an array
+    std::unique_ptr<Expression> array;
+    std::unique_ptr<DoEndBlock> body;
+
+    inline ForBlock(LocalScope& parentScope) :
+        Statement{ parentScope.getContext() },
+        scope{ parentScope },
+        variable{ nullptr } {}
+    
+    virtual llvm::Value* accept(qlow::StatementVisitor&, gen::FunctionGenerator&) override;
+};
+
+
+/*!
+ * \brief jumps to the case containing the value of an integer expression,
+ *        lowered to an llvm <code>switch</code>
+ */
+struct qlow::sem::MatchBlock : public Statement
+{
+    struct Case
+    {
+        /// two's complement bit patterns, truncated to the width of the type
+        std::vector<unsigned long long> values;
+        std::unique_ptr<DoEndBlock> body;
+    };
+
+    std::unique_ptr<Expression> value;
+    std::vector<Case> cases;
+    /// null if the cases cover all values or for <code>else unreachable</code>
+    std::unique_ptr<DoEndBlock> elseBlock;
+
+    inline MatchBlock(Context& context) :
+        Statement{ context } {}
+    
+    virtual llvm::Value* accept(qlow::StatementVisitor&, gen::FunctionGenerator&) override;
+};
+
+
+/*!
+ * \brief allocates the objects created while executing the body from a
+ *        region, which is freed when the body is left
+ *
+ * The region is dynamically scoped, i.e. <code>new</code> in methods called
+ * from the body allocates from it as well. Regions can be nested, the
+ * innermost one is used.
+ */
+struct qlow::sem::RegionBlock : public Statement
+{
+    std::unique_ptr<DoEndBlock> body;
+
+    inline RegionBlock(std::unique_ptr<DoEndBlock> body) :
+        Statement{ body->context },
+        body{ std::move(body) }
+    {
+    }
+
+    virtual llvm::Value* accept(qlow::StatementVisitor&, gen::FunctionGenerator&) override;
+};
+
+
 struct qlow::sem::AssignmentStatement : public Statement 
 {
     std::unique_ptr<Expression> target;
@@ -293,6 +411,23 @@ struct qlow::sem::ReturnStatement : public Statement
 };
 
 
+/*!
+ * \brief frees an object or the elements of an array
+ *
+ * Inside of a region, the memory is only reclaimed together with the
+ * region. A deleted local variable is set to null.
+ */
+struct qlow::sem::DeleteStatement : public Statement
+{
+    std::unique_ptr<Expression> value;
+
+    inline DeleteStatement(Context& context) :
+        Statement{ context } {}
+
+    virtual llvm::Value* accept(qlow::StatementVisitor&, gen::FunctionGenerator&) override;
+};
+
+
 struct qlow::sem::Expression :
     public SemanticObject,
     public Visitable<llvm::Value*,
@@ -367,15 +502,23 @@ struct qlow::sem::ArrayAccessExpression : public Expression
     std::unique_ptr<sem::Expression> array;
     std::unique_ptr<sem::Expression> index;
 
+    /// cleared if the index is proven to be in range (see BoundsAnalysis.h)
+    bool needsBoundsCheck;
+
     inline ArrayAccessExpression(std::unique_ptr<sem::Expression> array,
                                  std::unique_ptr<sem::Expression> index,
                                  const CodePosition& pos) :
         Expression{ array->context, array->type->getArrayOf(), pos },
         array{ std::move(array) },
-        index{ std::move(index) }
+        index{ std::move(index) },
+        needsBoundsCheck{ true }
     {
     }
 
+    /// the fields of an element of an @soa array are not stored together,
+    /// only the fields themselves can be assigned
+    inline virtual bool isLValue(void) const override { return !array->type->isSoaArrayType(); }
+
     virtual llvm::Value* accept(ExpressionCodegenVisitor& visitor, llvm::IRBuilder<>& arg2) override;
     virtual llvm::Value* accept(LValueVisitor& visitor, qlow::gen::FunctionGenerator&) override;
 
@@ -481,15 +624,30 @@ struct qlow::sem::UnaryOperation : public Operation
 
 struct qlow::sem::MethodCallExpression : public Expression
 {
+    /// how a call in tail position is generated, see \ref markTailCalls
+    enum class TailCall
+    {
+        /// an ordinary call
+        NONE,
+        /// a call the backend may turn into a jump
+        TAIL,
+        /// a call that is guaranteed to be turned into a jump
+        MUST_TAIL,
+        /// a self-recursive call, replaced by a jump to the function start
+        LOOP,
+    };
+
     Method* callee;
     std::unique_ptr<Expression> target;
     OwningList<Expression> arguments;
+    TailCall tailCall;
     
     inline MethodCallExpression(std::unique_ptr<Expression> target,
                                 Method* callee, const CodePosition& pos) :
         Expression{ callee->context, callee->returnType, pos },
         callee{ callee },
-        target{ std::move(target) }
+        target{ std::move(target) },
+        tailCall{ TailCall::NONE }
     {
     }
     
@@ -513,7 +671,14 @@ struct qlow::sem::FieldAccessExpression : public Expression
     {
     }
     
-    inline virtual bool isLValue(void) const override { return true; }
+    /// fields of struct temporaries can't be assigned
+    inline virtual bool isLValue(void) const override
+    {
+        return !target->type->isStructType() || target->isLValue() || isSoaField();
+    }
+
+    /// true if the field is stored in a column of an @soa array
+    bool isSoaField(void) const;
     
     virtual llvm::Value* accept(ExpressionCodegenVisitor& visitor, llvm::IRBuilder<>& arg2) override;
     virtual llvm::Value* accept(LValueVisitor& visitor, qlow::gen::FunctionGenerator&) override;
@@ -537,6 +702,21 @@ struct qlow::sem::IntConst : public Expression
 };
 
 
+struct qlow::sem::FloatConst : public Expression
+{
+    double value;
+
+    inline FloatConst(Context& context, double value, const CodePosition& pos) :
+        Expression{ context, context.getNativeType(NativeType::NType::FLOAT64), pos },
+        value{ value }
+    {
+    }
+
+    virtual llvm::Value* accept(ExpressionCodegenVisitor& visitor, llvm::IRBuilder<>& arg2) override;
+    virtual std::string toString(void) const override;
+};
+
+
 struct qlow::sem::FeatureCallStatement : public Statement 
 {
     std::unique_ptr<MethodCallExpression> expr;
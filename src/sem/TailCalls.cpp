@@ -0,0 +1,223 @@
+#include "TailCalls.h"
+#include "Semantic.h"
+#include "Builtin.h"
+#include "Traversal.h"
+#include "ErrorReporting.h"
+
+using namespace qlow::sem;
+using TailCall = MethodCallExpression::TailCall;
+
+namespace
+{
+
+bool isVoid(const Type* type)
+{
+    return type == nullptr || type->isVoid();
+}
+
+
+bool containsAddress(Expression& expr)
+{
+    bool found = false;
+    forEachExpression(expr, [&] (Expression& e) {
+        if (dynamic_cast<AddressExpression*>(&e))
+            found = true;
+    });
+    return found;
+}
+
+
+/// true for calls of \p method on the same object
+bool isSelfCall(const Method& method, const MethodCallExpression& call)
+{
+    if (call.callee != &method)
+        return false;
+    if (call.target == nullptr)
+        return true;
+    auto* target = dynamic_cast<const LocalVariableExpression*>(call.target.get());
+    return target != nullptr && target->var == method.thisExpression;
+}
+
+
+/// true if \p a and \p b are passed the same way, references are all pointers
+bool sameRepresentation(const Type* a, const Type* b)
+{
+    if (isVoid(a) || isVoid(b))
+        return isVoid(a) && isVoid(b);
+    return a == b || (a->isReferenceType() && b->isReferenceType());
+}
+
+
+bool sameSignature(const Method& caller, const Method& callee)
+{
+    if ((caller.thisExpression == nullptr) != (callee.thisExpression == nullptr) ||
+        caller.arguments.size() != callee.arguments.size() ||
+        !sameRepresentation(caller.returnType, callee.returnType))
+        return false;
+    for (size_t i = 0; i < caller.arguments.size(); i++) {
+        if (!sameRepresentation(caller.arguments[i]->type, callee.arguments[i]->type))
+            return false;
+    }
+    return true;
+}
+
+
+/*!
+ * \brief decides how \p call, which is in tail position, is generated
+ *
+ * \param loopPossible false if the local variables of \p caller must not
+ *        be reused by a recursive call
+ * \return the reason why the call is not turned into a jump, or an empty
+ *         string if it is
+ */
+std::string markTailCall(Method& caller, MethodCallExpression& call, bool loopPossible)
+{
+    // native methods are generated inline
+    if (dynamic_cast<NativeMethod*>(call.callee) != nullptr)
+        return "";
+
+    const Method& callee = *call.callee;
+    bool scalarArguments = true;
+    for (auto* argument : callee.arguments) {
+        if (argument->type->isStructType() || argument->type->isArrayType())
+            scalarArguments = false;
+    }
+
+    if (isSelfCall(caller, call) && loopPossible && scalarArguments) {
+        call.tailCall = TailCall::LOOP;
+        caller.isTailRecursive = true;
+        return "";
+    }
+
+    // the callee must not access the stack frame of the caller, which is
+    // gone once it runs
+    bool addressTaken = false;
+    forEachSubexpression(call, [&] (Expression& e) {
+        if (containsAddress(e))
+            addressTaken = true;
+    });
+    if (addressTaken)
+        return "an argument may point to a local variable";
+    if (call.target != nullptr && call.target->type->isStructType())
+        return "the called struct may be stored in the stack frame of the caller";
+    for (auto* argument : callee.arguments) {
+        if (argument->type->isStructType())
+            return "struct arguments are passed in the stack frame of the caller";
+    }
+    if (!isVoid(callee.returnType) && callee.returnType->isStructType())
+        return "struct results are returned in the stack frame of the caller";
+
+    call.tailCall = TailCall::TAIL;
+    if (!sameSignature(caller, callee))
+        return "'" + callee.name + "' does not have the same signature as '" + caller.name + "'";
+
+    call.tailCall = TailCall::MUST_TAIL;
+    return "";
+}
+
+
+/*!
+ * \brief calls \p f for the calls in tail position in \p block
+ *
+ * \param isTail true if nothing follows \p block before the method returns
+ */
+void forEachTailCall(DoEndBlock& block, bool isTail,
+    const std::function<void(MethodCallExpression&)>& f)
+{
+    for (size_t i = 0; i < block.statements.size(); i++) {
+        Statement& statement = *block.statements[i];
+        bool isLast = isTail && i + 1 == block.statements.size();
+        if (auto* ret = dynamic_cast<ReturnStatement*>(&statement)) {
+            if (auto* call = dynamic_cast<MethodCallExpression*>(ret->value.get()))
+                f(*call);
+        }
+        else if (auto* call = dynamic_cast<FeatureCallStatement*>(&statement)) {
+            if (isLast)
+                f(*call->expr);
+        }
+        else if (auto* ifElse = dynamic_cast<IfElseBlock*>(&statement)) {
+            forEachTailCall(*ifElse->ifBlock, isLast, f);
+            if (ifElse->elseBlock)
+                forEachTailCall(*ifElse->elseBlock, isLast, f);
+        }
+        else if (auto* match = dynamic_cast<MatchBlock*>(&statement)) {
+            for (auto& c : match->cases)
+                forEachTailCall(*c.body, isLast, f);
+            if (match->elseBlock)
+                forEachTailCall(*match->elseBlock, isLast, f);
+        }
+        else if (auto* loop = dynamic_cast<WhileBlock*>(&statement)) {
+            forEachTailCall(*loop->body, false, f);
+        }
+        else if (auto* loop = dynamic_cast<ForBlock*>(&statement)) {
+            forEachTailCall(*loop->body, false, f);
+        }
+        else if (auto* nested = dynamic_cast<DoEndBlock*>(&statement)) {
+            forEachTailCall(*nested, isLast, f);
+        }
+        // calls in a region are never tail calls, as the region is freed
+        // after they return
+
+    }
+}
+
+} // namespace
+
+
+void qlow::sem::markTailCalls(Method& method)
+{
+    if (!method.body)
+        return;
+
+    // a recursive call turned into a loop reuses the local variables,
+    // which must not be visible through pointers
+    bool addressTaken = false;
+    forEachStatement(*method.body, [&] (Statement& s) {
+        forEachOwnExpression(s, [&] (Expression& e) {
+            if (containsAddress(e))
+                addressTaken = true;
+        });
+    });
+
+    // the objects of owned variables are freed after the call returns
+    const Variable* owned = nullptr;
+    forEachStatement(*method.body, [&] (Statement& s) {
+        if (auto* block = dynamic_cast<DoEndBlock*>(&s)) {
+            for (auto& [name, var] : block->scope.getLocals()) {
+                if (var->isOwned)
+                    owned = var.get();
+            }
+        }
+    });
+    if (owned != nullptr) {
+        if (method.guaranteedTailCalls)
+            throw SemanticError(SemanticError::NO_TAIL_CALL,
+                "owned variable '" + owned->name + "' is freed after the call", owned->pos);
+        return;
+    }
+
+    // calls in the last statement of methods without a result are
+    // followed by nothing but the return
+    forEachTailCall(*method.body, isVoid(method.returnType), [&] (MethodCallExpression& call) {
+        std::string reason = markTailCall(method, call, !addressTaken);
+        if (method.guaranteedTailCalls && !reason.empty())
+            throw SemanticError(SemanticError::NO_TAIL_CALL, reason, call.pos);
+    });
+
+    if (!method.guaranteedTailCalls)
+        return;
+
+    // every recursion must go through a jump, otherwise the stack still grows
+    forEachStatement(*method.body, [&] (Statement& s) {
+        forEachOwnExpression(s, [&] (Expression& e) {
+            forEachExpression(e, [&] (Expression& sub) {
+                auto* call = dynamic_cast<MethodCallExpression*>(&sub);
+                if (call != nullptr && call->callee == &method &&
+                    call->tailCall != TailCall::LOOP && call->tailCall != TailCall::MUST_TAIL)
+                    throw SemanticError(SemanticError::NO_TAIL_CALL,
+                        "recursive call of '" + method.name + "' is not in tail position",
+                        call->pos);
+            });
+        });
+    });
+}
@@ -0,0 +1,30 @@
+#ifndef QLOW_SEM_TAILCALLS_H
+#define QLOW_SEM_TAILCALLS_H
+
+namespace qlow
+{
+    namespace sem
+    {
+        struct Method;
+
+        /*!
+         * \brief sets \ref MethodCallExpression::tailCall on the calls in
+         *        tail position
+         *
+         * A call is in tail position if its result is returned right away,
+         * or if it is the last statement of a method without return value.
+         * Self-recursive calls with scalar arguments become jumps to the
+         * start of the method. Calls to methods with the same signature
+         * are marked <code>musttail</code>, other calls that cannot refer
+         * to the stack frame of the caller <code>tail</code>.
+         *
+         * \throws SemanticError if the method is annotated with
+         *         <code>@tailcall</code> and a call in tail position cannot
+         *         be made a jump or a recursive call is not in tail position
+         */
+        void markTailCalls(Method& method);
+    }
+}
+
+
+#endif // QLOW_SEM_TAILCALLS_H
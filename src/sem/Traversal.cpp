@@ -0,0 +1,114 @@
+#include "Traversal.h"
+#include "Semantic.h"
+
+using namespace qlow::sem;
+
+
+void qlow::sem::forEachSubexpression(Expression& expr, const std::function<void(Expression&)>& f)
+{
+    if (auto* binop = dynamic_cast<BinaryOperation*>(&expr)) {
+        f(*binop->left);
+        f(*binop->right);
+    }
+    else if (auto* unop = dynamic_cast<UnaryOperation*>(&expr)) {
+        f(*unop->arg);
+    }
+    else if (auto* cast = dynamic_cast<CastExpression*>(&expr)) {
+        f(*cast->expression);
+    }
+    else if (auto* newArray = dynamic_cast<NewArrayExpression*>(&expr)) {
+        f(*newArray->length);
+    }
+    else if (auto* call = dynamic_cast<MethodCallExpression*>(&expr)) {
+        if (call->target)
+            f(*call->target);
+        for (auto& argument : call->arguments)
+            f(*argument);
+    }
+    else if (auto* access = dynamic_cast<FieldAccessExpression*>(&expr)) {
+        if (access->target)
+            f(*access->target);
+    }
+    else if (auto* address = dynamic_cast<AddressExpression*>(&expr)) {
+        f(*address->target);
+    }
+    else if (auto* access = dynamic_cast<ArrayAccessExpression*>(&expr)) {
+        f(*access->array);
+        f(*access->index);
+    }
+}
+
+
+void qlow::sem::forEachExpression(Expression& expr, const std::function<void(Expression&)>& f)
+{
+    f(expr);
+    forEachSubexpression(expr, [&f] (Expression& sub) { forEachExpression(sub, f); });
+}
+
+
+void qlow::sem::forEachStatement(Statement& statement, const std::function<void(Statement&)>& f)
+{
+    f(statement);
+    if (auto* block = dynamic_cast<DoEndBlock*>(&statement)) {
+        for (auto& s : block->statements)
+            forEachStatement(*s, f);
+    }
+    else if (auto* ifElse = dynamic_cast<IfElseBlock*>(&statement)) {
+        forEachStatement(*ifElse->ifBlock, f);
+        if (ifElse->elseBlock)
+            forEachStatement(*ifElse->elseBlock, f);
+    }
+    else if (auto* loop = dynamic_cast<WhileBlock*>(&statement)) {
+        forEachStatement(*loop->body, f);
+    }
+    else if (auto* loop = dynamic_cast<ForBlock*>(&statement)) {
+        forEachStatement(*loop->body, f);
+    }
+    else if (auto* match = dynamic_cast<MatchBlock*>(&statement)) {
+        for (auto& c : match->cases)
+            forEachStatement(*c.body, f);
+        if (match->elseBlock)
+            forEachStatement(*match->elseBlock, f);
+    }
+    else if (auto* region = dynamic_cast<RegionBlock*>(&statement)) {
+        forEachStatement(*region->body, f);
+    }
+}
+
+
+void qlow::sem::forEachOwnExpression(Statement& statement, const std::function<void(Expression&)>& f)
+{
+    if (auto* ifElse = dynamic_cast<IfElseBlock*>(&statement)) {
+        f(*ifElse->condition);
+    }
+    else if (auto* loop = dynamic_cast<WhileBlock*>(&statement)) {
+        f(*loop->condition);
+    }
+    else if (auto* loop = dynamic_cast<ForBlock*>(&statement)) {
+        if (loop->array) {
+            f(*loop->array);
+        }
+        else {
+            f(*loop->from);
+            f(*loop->to);
+        }
+    }
+    else if (auto* match = dynamic_cast<MatchBlock*>(&statement)) {
+        f(*match->value);
+    }
+    else if (auto* assignment = dynamic_cast<AssignmentStatement*>(&statement)) {
+        // the value is evaluated before the target
+        f(*assignment->value);
+        f(*assignment->target);
+    }
+    else if (auto* ret = dynamic_cast<ReturnStatement*>(&statement)) {
+        if (ret->value)
+            f(*ret->value);
+    }
+    else if (auto* del = dynamic_cast<DeleteStatement*>(&statement)) {
+        f(*del->value);
+    }
+    else if (auto* call = dynamic_cast<FeatureCallStatement*>(&statement)) {
+        f(*call->expr);
+    }
+}
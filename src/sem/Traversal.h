@@ -0,0 +1,28 @@
+#ifndef QLOW_SEM_TRAVERSAL_H
+#define QLOW_SEM_TRAVERSAL_H
+
+#include <functional>
+
+namespace qlow
+{
+    namespace sem
+    {
+        struct Statement;
+        struct Expression;
+
+        /// calls \p f for the direct subexpressions of \p expr
+        void forEachSubexpression(Expression& expr, const std::function<void(Expression&)>& f);
+
+        /// calls \p f for \p expr and all expressions nested in it
+        void forEachExpression(Expression& expr, const std::function<void(Expression&)>& f);
+
+        /// calls \p f for \p statement and all statements nested in it
+        void forEachStatement(Statement& statement, const std::function<void(Statement&)>& f);
+
+        /// calls \p f for the expressions of \p statement, but not of nested statements
+        void forEachOwnExpression(Statement& statement, const std::function<void(Expression&)>& f);
+    }
+}
+
+
+#endif // QLOW_SEM_TRAVERSAL_H
@@ -6,6 +6,7 @@
 #include "ErrorReporting.h"
 
 #include <llvm/IR/Type.h>
+#include <llvm/IR/DerivedTypes.h>
 
 #include <map>
 #include <climits>
@@ -64,18 +65,6 @@ void Type::setTypeScope(std::unique_ptr<TypeScope> scope)
 }
 
 
-/*void Type::setLlvmType(llvm::Type* type)
-{
-    llvmType = type;
-}*/
-
-
-llvm::Type* Type::getLlvmType(llvm::LLVMContext& c) const
-{
-    return llvmType;
-}
-
-
 bool Type::isClassType(void) const
 {
     return false;
@@ -100,6 +89,12 @@ bool Type::isArrayType(void) const
 }
 
 
+bool Type::isSoaArrayType(void) const
+{
+    return false;
+}
+
+
 bool Type::isVoid(void) const
 {
     return false;
@@ -114,6 +109,22 @@ const std::vector<NativeType::NType> NativeType::nativeTypes = {
     NType::C_SHORT,
     NType::C_INT,
     NType::C_LONG,
+    NType::INT8,
+    NType::INT16,
+    NType::INT32,
+    NType::INT64,
+    NType::UINT8,
+    NType::UINT16,
+    NType::UINT32,
+    NType::UINT64,
+    NType::FLOAT32,
+    NType::FLOAT64,
+    NType::INT32X4,
+    NType::INT64X2,
+    NType::INT32X8,
+    NType::INT64X4,
+    NType::FLOAT32X8,
+    NType::FLOAT64X4,
 };
 
 
@@ -145,11 +156,96 @@ std::string NativeType::asString(void) const
         { NType::C_SHORT, "CShort" },
         { NType::C_INT, "CInt" },
         { NType::C_LONG, "CLong" },
+        { NType::INT8, "Int8" },
+        { NType::INT16, "Int16" },
+        { NType::INT32, "Int32" },
+        { NType::INT64, "Int64" },
+        { NType::UINT8, "UInt8" },
+        { NType::UINT16, "UInt16" },
+        { NType::UINT32, "UInt32" },
+        { NType::UINT64, "UInt64" },
+        { NType::FLOAT32, "Float32" },
+        { NType::FLOAT64, "Float64" },
+        { NType::INT32X4, "Int32x4" },
+        { NType::INT64X2, "Int64x2" },
+        { NType::INT32X8, "Int32x8" },
+        { NType::INT64X4, "Int64x4" },
+        { NType::FLOAT32X8, "Float32x8" },
+        { NType::FLOAT64X4, "Float64x4" },
     };
     return names.at(type);
 }
 
 
+bool NativeType::isFloatingPointType(void) const
+{
+    return type == NType::FLOAT32 || type == NType::FLOAT64;
+}
+
+
+bool NativeType::isUnsignedType(void) const
+{
+    switch(type) {
+    case NType::BOOLEAN:
+    case NType::UINT8:
+    case NType::UINT16:
+    case NType::UINT32:
+    case NType::UINT64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+unsigned NativeType::getLaneCount(void) const
+{
+    switch(type) {
+    case NType::INT64X2:
+        return 2;
+    case NType::INT32X4:
+    case NType::INT64X4:
+    case NType::FLOAT64X4:
+        return 4;
+    case NType::INT32X8:
+    case NType::FLOAT32X8:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+
+unsigned NativeType::getIntegerWidth(void) const
+{
+    switch(type) {
+    case NType::INTEGER:
+    case NType::INT64:
+    case NType::UINT64:
+        return 64;
+    case NType::C_CHAR:
+        return CHAR_BIT * sizeof(char);
+    case NType::C_SHORT:
+        return CHAR_BIT * sizeof(short);
+    case NType::C_INT:
+        return CHAR_BIT * sizeof(int);
+    case NType::C_LONG:
+        return CHAR_BIT * sizeof(long);
+    case NType::INT8:
+    case NType::UINT8:
+        return 8;
+    case NType::INT16:
+    case NType::UINT16:
+        return 16;
+    case NType::INT32:
+    case NType::UINT32:
+        return 32;
+    default:
+        return 0;
+    }
+}
+
+
 std::string NativeType::asIdentifier(void) const
 {
     return asString();
@@ -162,43 +258,71 @@ size_t NativeType::hash(void) const
 }
 
 
-void NativeType::createLlvmTypeDecl(llvm::LLVMContext& ctxt)
+static llvm::Type* createVectorType(llvm::Type* laneType, unsigned lanes)
+{
+#if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR >= 11
+    return llvm::FixedVectorType::get(laneType, lanes);
+#else
+    return llvm::VectorType::get(laneType, lanes);
+#endif
+}
+
+
+llvm::Type* NativeType::createLlvmTypeDecl(llvm::LLVMContext& ctxt) const
 {
     switch(type) {
     case NType::VOID:
-        llvmType = llvm::Type::getVoidTy(ctxt);
-        break;
+        return llvm::Type::getVoidTy(ctxt);
     case NType::INTEGER:
-        llvmType = llvm::Type::getInt64Ty(ctxt);
-        break;
+        return llvm::Type::getInt64Ty(ctxt);
     case NType::BOOLEAN:
-        llvmType = llvm::Type::getInt1Ty(ctxt);
-        break;
+        return llvm::Type::getInt1Ty(ctxt);
 #if CHAR_BIT == 8 && USHRT_MAX == 65535 && UINT_MAX == 4294967295
     case NType::C_CHAR:
-        llvmType = llvm::Type::getInt8Ty(ctxt);
-        break;
+        return llvm::Type::getInt8Ty(ctxt);
     case NType::C_SHORT:
-        llvmType = llvm::Type::getInt16Ty(ctxt);
-        break;
+        return llvm::Type::getInt16Ty(ctxt);
     case NType::C_INT:
-        llvmType = llvm::Type::getInt32Ty(ctxt);
-        break;
+        return llvm::Type::getInt32Ty(ctxt);
 #else
 #error unknown C abi
 #endif
 
 #if ULONG_MAX == 4294967295
     case NType::C_LONG:
-        llvmType = llvm::Type::getInt32Ty(ctxt);
-        break;
+        return llvm::Type::getInt32Ty(ctxt);
 #elif ULONG_MAX == 18446744073709551615ULL
     case NType::C_LONG:
-        llvmType = llvm::Type::getInt64Ty(ctxt);
-        break;
+        return llvm::Type::getInt64Ty(ctxt);
 #else
 #error unknown C abi
 #endif
+    case NType::INT8:
+    case NType::UINT8:
+        return llvm::Type::getInt8Ty(ctxt);
+    case NType::INT16:
+    case NType::UINT16:
+        return llvm::Type::getInt16Ty(ctxt);
+    case NType::INT32:
+    case NType::UINT32:
+        return llvm::Type::getInt32Ty(ctxt);
+    case NType::INT64:
+    case NType::UINT64:
+        return llvm::Type::getInt64Ty(ctxt);
+    case NType::FLOAT32:
+        return llvm::Type::getFloatTy(ctxt);
+    case NType::FLOAT64:
+        return llvm::Type::getDoubleTy(ctxt);
+    case NType::INT32X4:
+    case NType::INT32X8:
+        return createVectorType(llvm::Type::getInt32Ty(ctxt), getLaneCount());
+    case NType::INT64X2:
+    case NType::INT64X4:
+        return createVectorType(llvm::Type::getInt64Ty(ctxt), getLaneCount());
+    case NType::FLOAT32X8:
+        return createVectorType(llvm::Type::getFloatTy(ctxt), getLaneCount());
+    case NType::FLOAT64X4:
+        return createVectorType(llvm::Type::getDoubleTy(ctxt), getLaneCount());
     default:
         throw qlow::SemanticError(SemanticError::UNKNOWN_TYPE,
                 "invalid native type '" + asString() + "'",
@@ -255,15 +379,16 @@ size_t ClassType::hash(void) const
 }
 
 
-void ClassType::createLlvmTypeDecl(llvm::LLVMContext& ctxt)
+llvm::Type* ClassType::createLlvmTypeDecl(llvm::LLVMContext& ctxt) const
 {
-    llvmType = llvm::StructType::create(ctxt, asIdentifier());
+    return llvm::StructType::create(ctxt, asIdentifier());
 }
 
 
 bool ArrayType::equals(const Type& other) const
 {
-    return other.isArrayType() && elementType->equals(*static_cast<const ArrayType&>(other).elementType);
+    return other.isArrayType() && elementType->equals(*static_cast<const ArrayType&>(other).elementType) &&
+        soa == static_cast<const ArrayType&>(other).soa;
 }
 
 
@@ -273,6 +398,12 @@ bool ArrayType::isArrayType(void) const
 }
 
 
+bool ArrayType::isSoaArrayType(void) const
+{
+    return soa;
+}
+
+
 Type* ArrayType::getArrayOf(void) const
 {
     return elementType;
@@ -281,23 +412,23 @@ Type* ArrayType::getArrayOf(void) const
 
 std::string ArrayType::asString(void) const
 {
-    return "[" + elementType->asString() + "]";
+    return "[" + elementType->asString() + "]" + (soa ? " @soa" : "");
 }
 
 
 std::string ArrayType::asIdentifier(void) const
 {
-    return elementType->asString() + "_arr";
+    return elementType->asString() + (soa ? "_soa" : "_arr");
 }
 
 
 size_t ArrayType::hash(void) const
 {
-    return 2345792834579ull + elementType->hash() * 1234817233;
+    return 2345792834579ull + elementType->hash() * 1234817233 + (soa ? 1 : 0);
 }
 
 
-void ArrayType::createLlvmTypeDecl(llvm::LLVMContext& ctxt)
+llvm::Type* ArrayType::createLlvmTypeDecl(llvm::LLVMContext& ctxt) const
 {
-    llvmType = llvm::StructType::create(ctxt, asIdentifier());
+    return llvm::StructType::create(ctxt, asIdentifier());
 }
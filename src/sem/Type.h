@@ -49,7 +49,6 @@ class qlow::sem::Type
     friend class Context;
 protected:
     std::unique_ptr<TypeScope> typeScope;
-    llvm::Type* llvmType;
     Context& context;
 
     Type(Context& context);
@@ -99,16 +98,25 @@ public:
      */
     void setTypeScope(std::unique_ptr<TypeScope> scope);
 
-    //virtual void setLlvmType(llvm::Type* type);
-    virtual llvm::Type* getLlvmType(llvm::LLVMContext&) const;
-
-    virtual void createLlvmTypeDecl(llvm::LLVMContext&) = 0;
+    /**
+     * @brief creates the llvm type of this type in the given context
+     *
+     * Class and array types are returned as opaque structs, their body
+     * is set by the code generator.
+     */
+    virtual llvm::Type* createLlvmTypeDecl(llvm::LLVMContext&) const = 0;
 
     virtual bool isClassType(void) const;
     virtual bool isStructType(void) const;
     virtual bool isNativeType(void) const;
     virtual bool isArrayType(void) const;
 
+    /**
+     * @brief true for arrays annotated with <code>@soa</code>, which store
+     *        each field of their struct elements in a separate column
+     */
+    virtual bool isSoaArrayType(void) const;
+
     virtual bool isVoid(void) const;
 
     inline Context& getContext(void) const { return context; }
@@ -128,6 +136,25 @@ public:
         C_SHORT,
         C_INT,
         C_LONG,
+
+        INT8,
+        INT16,
+        INT32,
+        INT64,
+        UINT8,
+        UINT16,
+        UINT32,
+        UINT64,
+
+        FLOAT32,
+        FLOAT64,
+
+        INT32X4,
+        INT64X2,
+        INT32X8,
+        INT64X4,
+        FLOAT32X8,
+        FLOAT64X4,
     };
     static const std::vector<NType> nativeTypes;
 protected:
@@ -145,11 +172,25 @@ public:
     virtual bool isNativeType(void) const override;
     virtual bool isVoid(void) const override;
 
+    inline NType getNativeType(void) const { return type; }
+
+    /// number of lanes of a SIMD vector type, 0 for scalar types
+    unsigned getLaneCount(void) const;
+    inline bool isVectorType(void) const { return getLaneCount() != 0; }
+    bool isFloatingPointType(void) const;
+
+    /// number of bits of an integer type, 0 for all other types
+    unsigned getIntegerWidth(void) const;
+
+    /// true for the <code>UInt</code> types and Boolean, which are
+    /// zero-extended and compared without sign
+    bool isUnsignedType(void) const;
+
     virtual std::string asString(void) const override;
     virtual std::string asIdentifier(void) const override;
     virtual size_t hash(void) const override;
 
-    virtual void createLlvmTypeDecl(llvm::LLVMContext&) override;
+    virtual llvm::Type* createLlvmTypeDecl(llvm::LLVMContext&) const override;
 };
 
 
@@ -173,7 +214,7 @@ public:
     virtual std::string asString(void) const override;
     virtual std::string asIdentifier(void) const override;
     virtual size_t hash(void) const override;
-    virtual void createLlvmTypeDecl(llvm::LLVMContext&) override;
+    virtual llvm::Type* createLlvmTypeDecl(llvm::LLVMContext&) const override;
 };
 
 
@@ -182,20 +223,23 @@ class qlow::sem::ArrayType : public Type
     friend class Context;
 protected:
     Type* elementType;
-    inline ArrayType(Type* elementType) :
+    bool soa;
+    inline ArrayType(Type* elementType, bool soa) :
         Type{ elementType->getContext() },
-        elementType{ elementType }
+        elementType{ elementType },
+        soa{ soa }
     {
     }
 public:
     virtual bool equals(const Type& other) const override;
     virtual bool isArrayType(void) const override;
+    virtual bool isSoaArrayType(void) const override;
     virtual Type* getArrayOf(void) const override;
 
     virtual std::string asString(void) const override;
     virtual std::string asIdentifier(void) const override;
     virtual size_t hash(void) const override;
-    virtual void createLlvmTypeDecl(llvm::LLVMContext&) override;
+    virtual llvm::Type* createLlvmTypeDecl(llvm::LLVMContext&) const override;
 };
 
 
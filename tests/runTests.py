@@ -2,6 +2,7 @@
 
 import sys
 import os
+import re
 import subprocess
 import difflib
 
@@ -15,25 +16,128 @@ qlow_executable = sys.argv[1]
 succeeded = 0
 failed = 0
 
+# a test can pass additional compiler flags in a comment line like
+#
+#   // flags: -O2 -g
+#
+def read_flags(path):
+    with open(path, "r") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("// flags:"):
+                return line[len("// flags:"):].split()
+    return []
+
+
+# A test can also list regular expressions that must match somewhere in the
+# llvm ir emitted with the same flags, one per line:
+#
+#   // check: attributes #\d+ = \{[^}]*\bcold\b
+#
+def read_checks(path):
+    checks = []
+    with open(path, "r") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("// check:"):
+                checks.append(line[len("// check:"):].strip())
+    return checks
+
+
+# and the exit code the compiled program must return, usually the result
+# of main modulo 256:
+#
+#   // exit: 42
+#
+def read_exit_code(path):
+    with open(path, "r") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("// exit:"):
+                return int(line[len("// exit:"):])
+    return None
+
+
+def check_ir(path, flags, checks):
+    irfile = path + ".ll"
+    compile = [qlow_executable, path, "-o", irfile, "--emit-llvm"] + flags
+    result = subprocess.run(compile, stdout=subprocess.PIPE)
+    if result.returncode != 0 or not os.path.isfile(irfile):
+        print("    could not emit llvm ir")
+        return False
+    with open(irfile, "r") as f:
+        ir = f.read()
+    for check in checks:
+        if re.search(check, ir) is None:
+            print("    not found in llvm ir: " + check)
+            return False
+    return True
+
+
+# -fprofile-use without a file name in the flags makes a round trip through
+# profile guided optimization: the test is built with -fprofile-generate
+# instead and run once, and its profile is merged with llvm-profdata (or
+# $LLVM_PROFDATA) and passed to the actual build.
+#
+def train_profile(path, flags):
+    exefile = path + ".train"
+    rawfile = path + ".profraw"
+    datafile = path + ".profdata"
+    compile = [qlow_executable, path, "-o", exefile, "-fprofile-generate"] + flags
+    result = subprocess.run(compile, stdout=subprocess.PIPE)
+    if result.returncode != 0 or not os.path.isfile(exefile):
+        return None
+    env = dict(os.environ, LLVM_PROFILE_FILE=rawfile)
+    subprocess.run([exefile], stdout=subprocess.DEVNULL, env=env)
+    os.remove(exefile)
+    if not os.path.isfile(rawfile):
+        return None
+    profdata = os.environ.get("LLVM_PROFDATA", "llvm-profdata")
+    result = subprocess.run([profdata, "merge", "-o", datafile, rawfile])
+    os.remove(rawfile)
+    if result.returncode != 0:
+        return None
+    return datafile
+
+
 def test_file(path):
-    test = [qlow_executable, path, "-o", path + ".o"]
+    global succeeded
+    global failed
+    flags = read_flags(path)
+    if "-fprofile-use" in flags:
+        others = [f for f in flags if f != "-fprofile-use"]
+        datafile = train_profile(path, others)
+        if datafile is None:
+            print("training run of " + path + " failed")
+            failed += 1
+            return
+        flags = others + ["-fprofile-use=" + datafile]
+    test = [qlow_executable, path, "-o", path + ".o"] + flags
     print("running test " + " ".join(test))
     output = subprocess.run(test, stdout=subprocess.PIPE)
     with open(path + ".c.out", "w") as out:
         out.write(output.stdout.decode("utf-8"))
     
+    checks = read_checks(path)
     with open(path + ".c.out", "r") as did, open(path + ".c.out.ref", "r") as should:
-        if did.readlines() == should.readlines():
-            global succeeded
-            succeeded += 1
-        else:
-            global failed
-            failed += 1
+        passed = did.readlines() == should.readlines() and \
+            (not checks or check_ir(path, flags, checks))
     
     exefile = path + ".o"
+    exit_code = read_exit_code(path)
     if os.path.isfile(exefile):
         runOut = subprocess.run(exefile, stdout=subprocess.PIPE)
+        if exit_code is not None and runOut.returncode != exit_code:
+            print("    exited with %d instead of %d" % (runOut.returncode, exit_code))
+            passed = False
+    elif exit_code is not None:
+        print("    no executable produced")
+        passed = False
 
+    if passed:
+        succeeded += 1
+    else:
+        failed += 1
 
 
 
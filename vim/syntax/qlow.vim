@@ -12,15 +12,18 @@ endif
 syntax match commenty "//.*"
 syntax region multicommenty start="/\*"  end="\*/" contains=multicommenty
 
-syn keyword keywordy class struct do end if while return extern as new import
+syn keyword keywordy class struct do end if while for in match case unreachable region delete owned return extern as new import
 syn keyword typey Integer Boolean Abool
+syn keyword typey Int32x4 Int64x2 Int32x8 Int64x4 Float32x8 Float64x4
 syn keyword typey String Char 
 syn keyword typey Float32 Float64
+syn keyword typey Int8 Int16 Int32 Int64 UInt8 UInt16 UInt32 UInt64
 
 
 syntax match identifiery "[a-zA-Z][a-zA-Z0-9]*"
 syntax match numbery "\d\+"
 syntax match stringy "\".\+\""
+syntax match annotationy "@[a-zA-Z_][a-zA-Z0-9_]*"
 
 syntax keyword operatory not or and xor
 syntax match operatory "\v\:\="
@@ -32,6 +35,7 @@ hi def link stringy String
 hi def link keywordy Keyword
 hi def link operatory Operator 
 hi def link typey Type
+hi def link annotationy PreProc
 hi def link commenty Comment
 hi def link multicommenty Comment
 " hi Operator guifg=#00FF00 guibg=NONE gui=NONE